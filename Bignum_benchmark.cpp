@@ -0,0 +1,339 @@
+/*
+    Bignum_benchmark.cpp
+
+    Purpose:
+    - Measures the BigInt kernels from bignum.h so the Karatsuba threshold can be
+        tuned for the machine, and reports RSA-sized modexp throughput.
+
+    What it prints:
+    1) Time per n-limb multiplication for a sweep of karatsubaThreshold values
+        (schoolbook only = threshold larger than n).
+    2) Modular exponentiations per second for 1024/2048/4096-bit odd moduli,
+        with a full-size exponent (private-key operation) and with e = 65537
+        (public-key operation).
+    3) RSA private operations per second, plain c^d mod n versus CRT
+        (RSAPrivateKey from rsa_key.h), for real 1024/2048-bit keys.
+    4) 2048/4096-bit private operations with 2, 3 and 4 prime keys, legs run
+        sequentially and with the legs on a ThreadPool (only helps with > 1 core).
+    5) Exponentiation strategies for full-size exponents: plain square-and-multiply,
+        sliding window (power) and constant-time fixed window (powerConstTime),
+        with the number of Montgomery multiplications and squarings each one needs.
+    6) Batch modexp (simd_modexp.h): one exponent and modulus over 64 bases,
+        scalar versus the AVX2 and AVX-512 IFMA lane kernels the CPU supports.
+    7) Signature verification under one key (e = 65537 and a 128-bit e): one by
+        one with batchPower against batchVerify (rsa_batch_verify.h), clean and
+        with one bad signature in the batch. With e = 65537 batchVerify itself
+        checks one by one; the 128-bit e runs the randomized screen.
+    8) Modular inversion: extended Euclid against the binary extended GCD for
+        word-size moduli, and against Lehmer and the constant-time safegcd for
+        256-4096-bit moduli.
+    9) Fixed-base exponentiation (fixed_base.h) for 63-bit exponents mod a 61-bit
+        prime: DynModInt::pow against FixedBase tables of several widths, with the
+        table size and build time.
+   10) ElGamal signature verification under one key, 62-bit safe prime p: three
+        separate powers, g^M plus one Shamir/Straus double power, and the
+        randomized batch test (elgamal_verify.h), clean and with one bad signature.
+   11) ElGamal decryption, 62-bit p: power plus modInverse per ciphertext against
+        decryptBatch (elgamal_decrypt.h) with the folded exponent and with
+        Montgomery's batch inversion.
+
+    Build & run:
+        g++ -O2 -march=native Bignum_benchmark.cpp -o bignum_bench && ./bignum_bench
+
+    Notes:
+    - Numbers depend on the CPU and compiler; re-run after changing bignum.h.
+*/
+
+#include "rsa_key.h"
+#include "rsa_batch_verify.h"
+#include "fixed_base.h"
+#include "elgamal_verify.h"
+#include "elgamal_decrypt.h"
+
+// Runs fn repeatedly for about `seconds` and returns operations per second
+template <class F>
+double opsPerSecond(F fn, double seconds = 0.5) {
+    using clk = chrono::steady_clock;
+    long long ops = 0;
+    auto start = clk::now();
+    double elapsed = 0;
+    while (elapsed < seconds) {
+        fn();
+        ops++;
+        elapsed = chrono::duration<double>(clk::now() - start).count();
+    }
+    return ops / elapsed;
+}
+
+// Forwards the engine interface to a Montgomery context, counting the operations
+template <class Ctx, class Elem>
+struct CountingContext {
+    const Ctx& ctx;
+    Elem one;
+    mutable long long muls = 0, sqrs = 0;
+
+    CountingContext(const Ctx& c) : ctx(c), one(c.one) {}
+    void mulInto(Elem& out, const Elem& a, const Elem& b) const { muls++; ctx.mulInto(out, a, b); }
+    void sqrInto(Elem& out, const Elem& a) const { sqrs++; ctx.sqrInto(out, a); }
+    void select(Elem& out, const vector<Elem>& table, u64 idx) const { ctx.select(out, table, idx); }
+};
+
+// Reference left-to-right square-and-multiply (one multiplication per set bit)
+template <class Ctx, class Elem, class BitFn>
+Elem binaryPow(const Ctx& ctx, const Elem& base, int bits, BitFn bit) {
+    Elem res = ctx.one;
+    for (int i = bits - 1; i >= 0; i--) {
+        ctx.sqrInto(res, res);
+        if (bit(i)) ctx.mulInto(res, res, base);
+    }
+    return res;
+}
+
+// Random probable prime with gcd(p-1, 65537) == 1 (Fermat test; good enough for a benchmark key)
+template <class RNG>
+BigInt findPrime(int bits, RNG& rng) {
+    while (true) {
+        BigInt c = randomBits(bits, rng);
+        if (!c.isOdd()) c += 1;
+        if ((c - 1) % BigInt(65537) == BigInt(0)) continue;
+        if (power(BigInt(2), c - 1, c) == BigInt(1) && power(BigInt(3), c - 1, c) == BigInt(1)) return c;
+    }
+}
+
+int main() {
+    mt19937_64 rng(2024);
+    int defaultThreshold = karatsubaThreshold;
+
+    cout << "Multiplication time (ns) by operand size and Karatsuba threshold\n";
+    vector<int> sizes = {16, 24, 32, 48, 64, 128};
+    vector<int> thresholds = {8, 16, 24, 32, 1 << 20};
+    cout << setw(8) << "limbs";
+    for (int t : thresholds) cout << setw(12) << (t == (1 << 20) ? string("schoolbook") : "thr=" + to_string(t));
+    cout << "\n";
+    for (int n : sizes) {
+        vector<u64> a(n), b(n), r(2 * n), scratch(karatsubaScratch(n));
+        for (auto& x : a) x = rng();
+        for (auto& x : b) x = rng();
+        cout << setw(8) << n;
+        for (int t : thresholds) {
+            karatsubaThreshold = t;
+            double ops = opsPerSecond([&] { mulKaratsuba(r.data(), a.data(), b.data(), n, scratch.data()); }, 0.2);
+            cout << setw(12) << fixed << setprecision(0) << 1e9 / ops;
+        }
+        cout << "\n";
+    }
+    karatsubaThreshold = defaultThreshold;
+
+    cout << "\nModular exponentiation throughput (threshold = " << karatsubaThreshold << ")\n";
+    cout << setw(8) << "bits" << setw(20) << "full exponent/s" << setw(20) << "e=65537 /s" << "\n";
+    for (int bits : {1024, 2048, 4096}) {
+        BigInt n = randomBits(bits, rng);
+        if (!n.isOdd()) n += 1;
+        BigInt base = randomBelow(n, rng);
+        BigInt d = randomBelow(n, rng);
+        BigMontgomery mont(n);
+        double full = opsPerSecond([&] { mont.pow(base, d); }, 1.0);
+        double pub = opsPerSecond([&] { mont.pow(base, BigInt(65537)); }, 0.5);
+        cout << setw(8) << bits << setw(20) << setprecision(1) << full << setw(20) << pub << "\n";
+    }
+
+    cout << "\nRSA private operation: plain vs CRT\n";
+    cout << setw(8) << "bits" << setw(20) << "power(c, d, n) /s" << setw(20) << "CRT /s" << setw(10) << "speedup" << "\n";
+    for (int bits : {1024, 2048}) {
+        BigInt p = findPrime(bits / 2, rng), q = findPrime(bits / 2, rng);
+        RSAPrivateKey key(p, q, BigInt(65537));
+        BigInt c = randomBelow(key.n, rng);
+        BigMontgomery mont(key.n);
+        double plain = opsPerSecond([&] { mont.pow(c, key.d); }, 1.0);
+        double crt = opsPerSecond([&] { key.privateOp(c); }, 1.0);
+        cout << setw(8) << bits << setw(20) << plain << setw(20) << crt << setw(9) << crt / plain << "x\n";
+    }
+
+    cout << "\nMulti-prime RSA private operation (" << thread::hardware_concurrency() << " hardware threads)\n";
+    ThreadPool legPool(3);   // legs 1..3 of a 4-prime key; leg 0 runs on the calling thread
+    cout << setw(8) << "bits" << setw(8) << "primes" << setw(20) << "sequential /s" << setw(20) << "parallel legs /s" << "\n";
+    for (int bits : {2048, 4096}) {
+        for (int k = 2; k <= 4; k++) {
+            vector<BigInt> primes;
+            for (int i = 0; i < k; i++) primes.push_back(findPrime(bits / k, rng));
+            RSAPrivateKey key(primes, BigInt(65537));
+            BigInt c = randomBelow(key.n, rng);
+            double seq = opsPerSecond([&] { key.privateOp(c); }, 1.0);
+            key.legPool = &legPool;
+            double par = opsPerSecond([&] { key.privateOp(c); }, 1.0);
+            cout << setw(8) << bits << setw(8) << k << setw(20) << seq << setw(20) << par << "\n";
+        }
+    }
+
+    cout << "\nExponentiation strategy (full-size exponent): multiplications + squarings, and ops/s\n";
+    cout << setw(8) << "bits" << setw(26) << "square-and-multiply" << setw(26) << "sliding window" << setw(26) << "fixed window (CT)" << "\n";
+    for (int bits : {1024, 2048, 4096}) {
+        BigInt n = randomBits(bits, rng);
+        if (!n.isOdd()) n += 1;
+        BigInt d = randomBelow(n, rng);
+        BigMontgomery mont(n);
+        vector<u64> a = mont.toMont(randomBelow(n, rng));
+        auto bit = [&d](int i) { return d.bit(i); };
+        int eb = d.bitLength();
+
+        CountingContext<BigMontgomery, vector<u64>> c1(mont), c2(mont), c3(mont);
+        binaryPow(c1, a, eb, bit);
+        slidingWindowPow(c2, a, eb, bit);
+        fixedWindowPow(c3, a, bits, bit);
+        double r1 = opsPerSecond([&] { binaryPow(mont, a, eb, bit); }, 1.0);
+        double r2 = opsPerSecond([&] { slidingWindowPow(mont, a, eb, bit); }, 1.0);
+        double r3 = opsPerSecond([&] { fixedWindowPow(mont, a, bits, bit); }, 1.0);
+        auto cell = [](long long m, long long s, double r) {
+            ostringstream os;
+            os << m << "M+" << s << "S " << fixed << setprecision(1) << r << "/s";
+            return os.str();
+        };
+        cout << setw(8) << bits << setw(26) << cell(c1.muls, c1.sqrs, r1) << setw(26) << cell(c2.muls, c2.sqrs, r2)
+             << setw(26) << cell(c3.muls, c3.sqrs, r3) << "\n";
+    }
+
+    SimdLevel best = detectSimd();
+    vector<SimdLevel> levels = {SimdLevel::Scalar};
+    if (best != SimdLevel::Scalar) levels.push_back(SimdLevel::AVX2);
+    if (best == SimdLevel::IFMA) levels.push_back(SimdLevel::IFMA);
+    cout << "\nBatch modexp over 64 bases, modexps per second (CPU: " << simdLevelName(best) << ")\n";
+    cout << setw(8) << "bits" << setw(10) << "exponent";
+    for (SimdLevel level : levels) cout << setw(12) << (level == SimdLevel::Scalar ? "scalar" : level == SimdLevel::AVX2 ? "AVX2" : "IFMA");
+    cout << "\n";
+    for (int bits : {1024, 2048, 4096}) {
+        BigInt n = randomBits(bits, rng);
+        if (!n.isOdd()) n += 1;
+        vector<BigInt> bases(64);
+        for (auto& b : bases) b = randomBelow(n, rng);
+        for (BigInt e : {randomBelow(n, rng), BigInt(65537)}) {
+            cout << setw(8) << bits << setw(10) << (e == BigInt(65537) ? "65537" : "full");
+            for (SimdLevel level : levels) {
+                double batches = opsPerSecond([&] { batchPower(bases, e, n, level); }, 1.0);
+                cout << setw(12) << setprecision(1) << batches * bases.size();
+            }
+            cout << "\n";
+        }
+    }
+
+    cout << "\nRSA signature verification, signatures per second (batches of 2048)\n";
+    cout << setw(8) << "bits" << setw(8) << "e" << setw(16) << "one by one" << setw(16) << "batchVerify" << setw(16) << "one bad"
+         << "\n";
+    for (int bits : {1024, 2048}) {
+        for (int eBits : {17, 128}) {
+            BigInt p = findPrime(bits / 2, rng), q = findPrime(bits / 2, rng), phi = (p - 1) * (q - 1), e(65537);
+            while (eBits > 17 && (e == BigInt(65537) || gcd(e, phi) != BigInt(1))) {
+                e = randomBits(eBits, rng);
+                if (!e.isOdd()) e += 1;
+            }
+            RSAPrivateKey key(p, q, e);
+            vector<BigInt> msgs(2048);
+            for (auto& m : msgs) m = randomBelow(key.n, rng);
+            vector<BigInt> sigs = key.privateOpBatch(msgs), forged = sigs;
+            forged[1000] += 1;
+            double single = opsPerSecond([&] { batchPower(sigs, key.e, key.n); }, 1.0);
+            double batch = opsPerSecond([&] { batchVerify(msgs, sigs, key.n, key.e); }, 1.0);
+            double bad = opsPerSecond([&] { batchVerify(msgs, forged, key.n, key.e); }, 1.0);
+            cout << setw(8) << bits << setw(8) << (eBits > 17 ? "128-bit" : "65537") << setprecision(0) << setw(16)
+                 << single * msgs.size() << setw(16) << batch * msgs.size() << setw(16) << bad * msgs.size() << "\n";
+        }
+    }
+
+    cout << "\nModular inversion, nanoseconds per inverse (odd moduli, random inputs)\n";
+    cout << setw(8) << "bits" << setw(12) << "Euclid" << setw(12) << "binary" << "\n";
+    for (int bits : {31, 62}) {
+        u64 m = (rng() >> (64 - bits)) | (1ULL << (bits - 1)) | 1;
+        vector<long long> xs(4096);
+        for (auto& x : xs)
+            do x = (long long)(rng() % (m - 1) + 1);
+            while (gcd(x, (long long)m) != 1);
+        long long sink = 0;
+        double euclid = opsPerSecond([&] { for (long long x : xs) sink += modInverseEuclid(x, (long long)m); });
+        double binary = opsPerSecond([&] { for (long long x : xs) sink += (long long)modInverseBinary((u64)x, m); });
+        cout << setw(8) << bits << setprecision(0) << setw(12) << 1e9 / (euclid * xs.size()) << setw(12)
+             << 1e9 / (binary * xs.size()) << (sink == 42 ? " " : "") << "\n";
+    }
+    cout << setw(8) << "bits" << setw(12) << "Euclid" << setw(12) << "Lehmer" << setw(12) << "safegcd" << "\n";
+    for (int bits : {256, 1024, 2048, 4096}) {
+        BigInt m = randomBits(bits, rng);
+        if (!m.isOdd()) m += 1;
+        BigInt a = randomBelow(m, rng);
+        while (gcd(a, m) != BigInt(1)) a = randomBelow(m, rng);
+        double euclid = opsPerSecond([&] { modInverseEuclid(a, m); });
+        double lehmer = opsPerSecond([&] { modInverseLehmer(a, m); });
+        double safe = opsPerSecond([&] { modInverseConstTime(a, m); });
+        cout << setw(8) << bits << setprecision(0) << setw(12) << 1e9 / euclid << setw(12) << 1e9 / lehmer << setw(12)
+             << 1e9 / safe << "\n";
+    }
+
+    cout << "\nFixed-base exponentiation mod 2^61 - 1, nanoseconds per power (63-bit exponents)\n";
+    DynModInt::setModulus((1ULL << 61) - 1);
+    DynModInt base(5);
+    vector<u64> exps(4096);
+    for (u64& e : exps) e = rng() >> 1;
+    long long sink = 0;
+    double generic = opsPerSecond([&] { for (u64 e : exps) sink += base.pow((long long)e).value(); });
+    cout << setw(10) << "pow" << setprecision(1) << setw(12) << 1e9 / (generic * exps.size()) << "\n";
+    cout << setw(10) << "width" << setw(12) << "ns" << setw(12) << "entries" << setw(12) << "KB" << setw(12)
+         << "build us" << "\n";
+    for (int w : {2, 4, 6, 8}) {
+        auto start = chrono::steady_clock::now();
+        FixedBase<DynModInt> table(base, w);
+        double build = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double fixedRate = opsPerSecond([&] { for (u64 e : exps) sink += table.pow(e).value(); });
+        cout << setw(10) << w << setw(12) << 1e9 / (fixedRate * exps.size()) << setw(12) << table.entries() << setw(12)
+             << table.bytes() / 1024.0 << setw(12) << build * 1e6 << (sink == 42 ? " " : "") << "\n";
+    }
+
+    cout << "\nElGamal signature verification, signatures per second (62-bit safe prime p, batches of 2048)\n";
+    {
+        long long p = 2984124312088505459LL;   // 2q + 1 with q prime: one product test per screen
+        long long g = 3, x = (long long)(rng() % (u64)(p - 2)) + 1, y = power(g, x, p);
+        vector<long long> ms, rs, ss;
+        while (ms.size() < 2048) {
+            long long M = (long long)(rng() % (u64)(p - 1)), k = (long long)(rng() % (u64)(p - 3)) + 2;
+            if (gcd(k, p - 1) != 1) continue;
+            long long r = power(g, k, p);
+            long long s = mulMod(modInverse(k, p - 1), ((M - mulMod(x, r, p - 1)) % (p - 1) + (p - 1)) % (p - 1), p - 1);
+            ms.push_back(M), rs.push_back(r), ss.push_back(s);
+        }
+        ElGamalVerifier verifier(p, g, y);
+        size_t n = ms.size(), bad = 0;
+        double naive = opsPerSecond([&] {
+            for (size_t i = 0; i < n; i++) bad += power(g, ms[i], p) != mulMod(power(y, rs[i], p), power(rs[i], ss[i], p), p);
+        });
+        double shamir = opsPerSecond([&] { for (size_t i = 0; i < n; i++) bad += !verifier.verify(ms[i], rs[i], ss[i]); });
+        double batch = opsPerSecond([&] { bad += !verifier.verifyBatch(ms, rs, ss).ok; });
+        vector<long long> forged = ss;
+        forged[n / 3] = (forged[n / 3] + 1) % (p - 1);
+        double oneBad = opsPerSecond([&] { verifier.verifyBatch(ms, rs, forged); });
+        cout << setw(16) << "three powers" << setw(16) << "Shamir" << setw(16) << "batch" << setw(16) << "batch, 1 bad" << "\n";
+        cout << setprecision(0) << setw(16) << naive * n << setw(16) << shamir * n << setw(16) << batch * n << setw(16)
+             << oneBad * n << (bad ? "  (unexpected failures)" : "") << "\n";
+    }
+
+    cout << "\nElGamal decryption, nanoseconds per ciphertext (62-bit p, 65536 ciphertexts, one thread)\n";
+    {
+        u64 p = 4611686018427387847ULL;   // 2^62 - 57, prime
+        u64 x = rng() % (p - 2) + 1, h = (u64)power(3, (long long)x, (long long)p);
+        vector<CipherRecord> cts(65536);
+        for (CipherRecord& r : cts) {
+            u64 k = rng() % (p - 2) + 1;
+            r.c1 = (u64)power(3, (long long)k, (long long)p);
+            r.c2 = (u64)mulMod((long long)(rng() % p), power((long long)h, (long long)k, (long long)p), (long long)p);
+        }
+        ThreadPool pool(1);
+        vector<u64> a(cts.size()), b(cts.size()), c(cts.size());
+        double single = opsPerSecond([&] {
+            for (size_t i = 0; i < cts.size(); i++) {
+                long long s = power((long long)cts[i].c1, (long long)x, (long long)p);
+                a[i] = (u64)mulMod((long long)cts[i].c2, modInverse(s, (long long)p), (long long)p);
+            }
+        });
+        double fold = opsPerSecond([&] { decryptBatch(p, x, cts.data(), cts.size(), b.data(), pool, DecryptMethod::FoldExponent); });
+        double batch = opsPerSecond([&] { decryptBatch(p, x, cts.data(), cts.size(), c.data(), pool, DecryptMethod::BatchInverse); });
+        cout << setw(16) << "pow + inverse" << setw(16) << "folded exponent" << setw(16) << "batch inverse" << "\n";
+        cout << setprecision(1) << setw(16) << 1e9 / (single * cts.size()) << setw(16) << 1e9 / (fold * cts.size())
+             << setw(16) << 1e9 / (batch * cts.size()) << (a != b || a != c ? "  (results differ)" : "") << "\n";
+    }
+    return 0;
+}
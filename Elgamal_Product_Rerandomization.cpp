@@ -1,6 +1,3 @@
-#include<bits/stdc++.h>
-using namespace std;
-
 /*
     ElGamal product / rerandomization demo
 
@@ -27,52 +24,44 @@ using namespace std;
      - The code currently selects deterministic small keys (key1/key2) by linear
          search; in practice use a secure RNG and ensure k is unique per encryption.
      - Inputs are expected to be small enough to fit in `long long` and M < p.
+     - Residues mod p are Fp (modint.h; -DFIXED_P=<prime> fixes p at build time), and
+         g^k / h^k come from FixedBase tables (fixed_base.h) built once per key, so an
+         encryption or rerandomization needs only a few multiplications, no squarings.
+     - Elgamal_rerandomize.cpp does the rerandomization for whole ciphertext files,
+         with the encryptions of 1 computed ahead of time (elgamal_rerandomize.h).
 */
 
-#define ll long long
+#include "modint.h"
+#include "fixed_base.h"
+#include "primes.h"
 
-ll gcd(ll a, ll b){
-    if(b == 0) return a;
-    return gcd(b, a % b);     
-}
-
-ll power(ll a, ll b, ll m){
-    ll result = 1;  
-    a = a % m;
-    while(b > 0){
-        if ( b & 1) result = (result * a) % m;
-        a = (a * a) % m;
-        b >>= 1;
-    }
-    return result;
-}
-
-ll modInverse(ll a, ll m){
-    ll m0=m, x=1, y=0;
-    if (m == 1) return 0;  
-
-    while(a > 1){   
-        ll q = a/m;
-        ll t = m;
-        m = a % m , a=t;
-        t = y;
-        y = x - q*y;
-        x = t;
-    }
-    if (x < 0) x = x+m0;  
-    return x;
-}
+#ifdef FIXED_P
+typedef ModInt<FIXED_P> Fp;
+#else
+typedef DynModInt Fp;
+#endif
+
+#define ll long long
 
 int main(){
     ll p, g;
     cout << "Enter the prime number and generator: ";
     cin >> p >> g;
+    if (p < 3 || p >= (1LL << 62) || !isPrime((u64)p)) {
+        cout << p << " is not an odd prime below 2^62.\n";
+        return 0;
+    }
+    Fp::setModulus(p);
 
     ll x;
     cout << "Enter the private key: ";
     cin >> x;
 
-    ll h = power(g,x,p);
+    Fp h = Fp(g).pow(x);
+
+    // g and h are fixed for this key: build their fixed-base tables once,
+    // every encryption below is then a few table multiplications
+    FixedBase<Fp> gTable(g), hTable(h);
 
     ll key1 = 13;
     while(key1 <= p-2 && gcd(key1,p-1)!=1){
@@ -94,23 +83,22 @@ int main(){
     cout << "Enter the message: ";
     cin >> m1 >> m2;
 
-    cout << "Enter message is: " << (m1*m2) % p << endl;
+    cout << "Enter message is: " << Fp(m1) * Fp(m2) << endl;
 
-    ll c11 = power(g,key1,p);
-    ll c21 = (m1*power(h,key1,p))%p;
+    Fp c11 = gTable.pow(key1);
+    Fp c21 = Fp(m1) * hTable.pow(key1);
 
     cout << "ciphertext: " << c11 << " " << c21 << endl;
 
-    ll c12 = power(g,key2,p);
-    ll c22 = (m2*power(h,key2,p))%p;
+    Fp c12 = gTable.pow(key2);
+    Fp c22 = Fp(m2) * hTable.pow(key2);
 
-    ll c1 = (c11*c12)%p;
-    ll c2 = (c21*c22)%p;
+    Fp c1 = c11 * c12;
+    Fp c2 = c21 * c22;
 
     cout << "ciphertext: " << c1 << " " << c2 << endl;
     
-    ll s = power(c1,x,p);
-    ll message = (c2 * modInverse(s,p))%p;
+    Fp message = c2 * c1.pow(p - 1 - x % (p - 1));   // c2 / c1^x, inverse folded into the exponent
 
     cout << "Decrypt: " << message << endl;
 
@@ -121,21 +109,20 @@ int main(){
     cout << "Enter the message: ";
     cin >> m1;
 
-    ll c11 = power(g,key1,p);
-    ll c21 = (m1*power(h,key1,p))%p;
+    Fp c11 = gTable.pow(key1);
+    Fp c21 = Fp(m1) * hTable.pow(key1);
 
     cout << "ciphertext: " << c11 << " " << c21 << endl;
 
-    ll c12 = power(g,key2,p);
-    ll c22 = power(h,key2,p);
+    Fp c12 = gTable.pow(key2);
+    Fp c22 = hTable.pow(key2);
 
-    ll c1 = (c11*c12)%p;
-    ll c2 = (c21*c22)%p;
+    Fp c1 = c11 * c12;
+    Fp c2 = c21 * c22;
 
     cout << "New ciphertext: " << c1 << " " << c2 << endl;
     
-    ll s = power(c1,x,p);
-    ll message = (c2 * modInverse(s,p))%p;
+    Fp message = c2 * c1.pow(p - 1 - x % (p - 1));   // c2 / c1^x, inverse folded into the exponent
 
     cout << "Decrypt: " << message << endl;
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+/*
+    Elgamal_batch.cpp — bulk ElGamal encryption / decryption through a worker pool
+
+    Purpose:
+    - Elgamal_encryption.cpp encrypts one number and prints (C1, C2) as text. This
+        program encrypts a whole stream of messages on every core and writes the
+        ciphertexts to a binary file (elgamal_file.h) that decryption maps into
+        memory and splits between the workers without parsing anything.
+
+    Usage:
+        ./Elgamal_batch keygen [params.txt] > key.txt
+        ./Elgamal_batch encrypt <key file> <out.egc> [input|-] [--threads N]
+        ./Elgamal_batch decrypt <key file> <in.egc> [--method fold|batch] [--threads N] > plain.txt
+    - keygen takes p and g from an Elgamal_params file (p at most 62 bits) or
+        generates a 62-bit safe-prime group, then picks x at random. The public key
+        file is the same file without the x line; encrypt only needs that.
+    - Input is one decimal message per line, 0 <= M < p. A line that does not
+        parse or is out of range becomes an error record (c1 = 0), and decrypt
+        prints "error" for it, so the output lines up with the input.
+    - --method picks how decrypt avoids a modular inverse per record
+        (elgamal_decrypt.h): fold = c2 * c1^(p-1-x) (default), batch = c1^x for the
+        whole batch, then one Montgomery batch inversion.
+
+    Pipeline (orderedPipeline, thread_pool.h):
+        encrypt: reader (this thread) -> batches of RECORDS_PER_BATCH messages -> workers
+            -> writer appending fixed-width records to the file, in input order
+        decrypt: the file is mapped; each batch is just a record range, the workers
+            decrypt their range with decryptRange and the writer prints results in order
+    - Each worker draws k from its own thread_local RNG (no shared generator, no lock)
+        and computes g^k and h^k from FixedBase tables built once for the key.
+    - A summary (records, errors, throughput) goes to stderr.
+*/
+
+#include "elgamal_decrypt.h"
+#include "elgamal_params.h"
+#include "fixed_base.h"
+
+typedef DynModInt Fp;
+
+const size_t RECORDS_PER_BATCH = 4096;   // messages or records handed to a worker at once
+const size_t BATCHES_IN_FLIGHT = 4;      // per worker thread, bounds memory use
+
+struct EncryptBatch {
+    vector<long long> messages;
+    vector<char> valid;
+    vector<CipherRecord> out;
+};
+
+struct DecryptBatch {
+    u64 begin = 0, end = 0;   // record range in the mapped file
+    string out;
+};
+
+int keygen(const char* paramsPath) {
+    ElGamalParams params;
+    if (paramsPath) {
+        if (!loadElGamalParams(paramsPath, params)) return 1;
+        if (params.p.bitLength() > ELGAMAL_MAX_P_BITS) {
+            cerr << "p has " << params.p.bitLength() << " bits; the key file holds at most " << ELGAMAL_MAX_P_BITS << "\n";
+            return 1;
+        }
+    } else {
+        ThreadPool pool;
+        params = generateSafePrimeParams(ELGAMAL_MAX_P_BITS, pool);
+    }
+    ElGamalKey key;
+    key.p = (long long)params.p.low();
+    key.g = (long long)params.g.low();
+    mt19937_64 rng(random_device{}());
+    key.x = uniform_int_distribution<long long>(1, key.p - 2)(rng);
+    key.h = power(key.g, key.x, key.p);
+    writeElGamalKey(cout, key, true);
+    return 0;
+}
+
+void report(const string& mode, u64 records, u64 errors, double seconds, unsigned threads) {
+    cerr << mode << ": " << records << " records, " << errors << " errors, " << fixed << setprecision(2) << seconds
+         << " s (" << setprecision(0) << records / max(seconds, 1e-9) << " records/s, " << threads << " threads)\n";
+}
+
+int encrypt(const ElGamalKey& key, const string& outPath, const string& inputPath, ThreadPool& pool) {
+    ifstream file;
+    if (inputPath != "-") {
+        file.open(inputPath);
+        if (!file) {
+            cerr << "cannot open " << inputPath << "\n";
+            return 1;
+        }
+    }
+    istream& in = inputPath == "-" ? cin : file;
+    CipherFileWriter writer;
+    if (!writer.open(outPath, key)) {
+        cerr << "cannot create " << outPath << "\n";
+        return 1;
+    }
+
+    FixedBase<Fp> gTable(key.g), hTable(key.h);
+    long long p = key.p;
+    atomic<u64> errors(0);
+
+    auto read = [&](EncryptBatch& batch) {
+        string line;
+        while (batch.valid.size() < RECORDS_PER_BATCH && getline(in, line)) {
+            istringstream fields(line);
+            string tok, extra;
+            if (!(fields >> tok)) continue;
+            long long m = -1;
+            size_t used = 0;
+            try {
+                m = stoll(tok, &used);
+            } catch (const exception&) {
+            }
+            bool ok = used == tok.size() && !(fields >> extra) && m >= 0 && m < p;
+            batch.messages.push_back(ok ? m : 0);
+            batch.valid.push_back(ok);
+        }
+        return !batch.valid.empty();
+    };
+
+    auto work = [&](EncryptBatch& batch) {
+        static thread_local mt19937_64 rng(random_device{}());
+        uniform_int_distribution<long long> pickK(1, p - 2);
+        batch.out.resize(batch.valid.size());
+        for (size_t i = 0; i < batch.valid.size(); i++) {
+            if (!batch.valid[i]) {
+                batch.out[i] = CipherRecord{0, 0};
+                errors++;
+                continue;
+            }
+            u64 k = (u64)pickK(rng);
+            batch.out[i].c1 = (u64)gTable.pow(k).value();
+            batch.out[i].c2 = (u64)(Fp(batch.messages[i]) * hTable.pow(k)).value();
+        }
+    };
+
+    auto write = [&](EncryptBatch& batch) { writer.append(batch.out.data(), batch.out.size()); };
+
+    auto start = chrono::steady_clock::now();
+    orderedPipeline<EncryptBatch>(pool, BATCHES_IN_FLIGHT * pool.size(), read, work, write);
+    bool ok = writer.close();
+    report("encrypt", writer.count(), errors, chrono::duration<double>(chrono::steady_clock::now() - start).count(), pool.size());
+    if (!ok) {
+        cerr << "write to " << outPath << " failed\n";
+        return 1;
+    }
+    return 0;
+}
+
+int decrypt(const ElGamalKey& key, const string& inPath, DecryptMethod method, ThreadPool& pool) {
+    if (!key.hasPrivate()) {
+        cerr << "decrypt needs a key file with x\n";
+        return 1;
+    }
+    CipherFileReader file;
+    if (!file.open(inPath)) return 1;
+    const CipherFileHeader& hdr = file.header();
+    if ((long long)hdr.p != key.p || (long long)hdr.g != key.g || (long long)hdr.h != key.h) {
+        cerr << inPath << " was encrypted under a different key\n";
+        return 1;
+    }
+
+    const CipherRecord* records = file.records();
+    u64 count = file.count(), next = 0;
+    Montgomery mont((u64)key.p);
+    atomic<u64> errors(0);
+
+    auto read = [&](DecryptBatch& batch) {
+        batch.begin = next;
+        batch.end = next = min(count, next + RECORDS_PER_BATCH);
+        return batch.begin < batch.end;
+    };
+
+    auto work = [&](DecryptBatch& batch) {
+        static thread_local vector<u64> plain;
+        plain.resize(batch.end - batch.begin);
+        decryptRange(mont, (u64)key.x, records + batch.begin, plain.size(), plain.data(), method);
+        for (u64 m : plain) {
+            if (m == DECRYPT_ERROR) {
+                batch.out += "error\n";
+                errors++;
+                continue;
+            }
+            batch.out += to_string(m);
+            batch.out += '\n';
+        }
+    };
+
+    auto write = [](DecryptBatch& batch) { cout.write(batch.out.data(), batch.out.size()); };
+
+    auto start = chrono::steady_clock::now();
+    orderedPipeline<DecryptBatch>(pool, BATCHES_IN_FLIGHT * pool.size(), read, work, write);
+    cout.flush();
+    report("decrypt", count, errors, chrono::duration<double>(chrono::steady_clock::now() - start).count(), pool.size());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);
+    string usage = "usage: Elgamal_batch keygen [params file]\n"
+                   "       Elgamal_batch encrypt <key file> <out.egc> [input|-] [--threads N]\n"
+                   "       Elgamal_batch decrypt <key file> <in.egc> [--method fold|batch] [--threads N]\n";
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "keygen") return keygen(argc > 2 ? argv[2] : nullptr);
+    if ((mode != "encrypt" && mode != "decrypt") || argc < 4) {
+        cerr << usage;
+        return 1;
+    }
+
+    string inputPath = "-";
+    unsigned threads = 0;
+    DecryptMethod method = DecryptMethod::FoldExponent;
+    for (int i = 4; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+        else if (arg == "--method" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name != "fold" && name != "batch") {
+                cerr << usage;
+                return 1;
+            }
+            method = name == "fold" ? DecryptMethod::FoldExponent : DecryptMethod::BatchInverse;
+        } else inputPath = arg;
+    }
+
+    ElGamalKey key;
+    if (!loadElGamalKey(argv[2], key)) return 1;
+    Fp::setModulus(key.p);   // before any worker starts (DynModInt keeps one shared modulus)
+    ThreadPool pool(threads);
+    return mode == "encrypt" ? encrypt(key, argv[3], inputPath, pool) : decrypt(key, argv[3], method, pool);
+}
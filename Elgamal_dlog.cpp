@@ -0,0 +1,115 @@
+/*
+    Elgamal_dlog.cpp — ElGamal key-recovery audit: recover x from h = g^x mod p
+
+    Purpose:
+    - Elgamal_encryption.cpp accepts any prime p. Whether x stays secret depends
+        on p - 1: if the order of g has only small prime factors, Pohlig–Hellman
+        reduces the discrete log to small ones and x falls out in milliseconds.
+        This program runs that attack (elgamal_dlog.h) and reports how long it
+        took, so a weak p is shown to be weak rather than assumed to be.
+
+    Usage:
+        ./Elgamal_dlog <key file> [--bsgs] [--threads N]
+        ./Elgamal_dlog <p> <g> <h> [--bsgs] [--threads N]
+    - The key file is the one Elgamal_batch keygen writes; a public key is enough.
+        When it also holds x, the recovered value is checked against it.
+    - --bsgs also runs plain baby-step giant-step over the whole order of g, for
+        comparison (only when the order has at most GENERIC_BSGS_MAX_BITS bits).
+
+    Output:
+    - the factorization of p - 1 and its time, the order of g
+    - per prime power q^e: method (BSGS / parallel Pollard rho), group operations, time
+    - x, the total time, and the bit length of the largest prime factor of the
+        order, which is what sets the cost (about sqrt(q) operations)
+
+    Notes:
+    - p below 2^63. A 62-bit safe prime (Elgamal_params safe 62) leaves one 61-bit
+        q: the rho phase then takes tens of seconds on one core.
+*/
+
+#include "elgamal_dlog.h"
+#include "elgamal_file.h"
+
+const int GENERIC_BSGS_MAX_BITS = 44;   // 2^22 baby steps, 32 MB table
+
+int main(int argc, char** argv) {
+    string usage = "usage: Elgamal_dlog <key file> [--bsgs] [--threads N]\n"
+                   "       Elgamal_dlog <p> <g> <h> [--bsgs] [--threads N]\n";
+    vector<string> args;
+    bool generic = false;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bsgs") generic = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+        else args.push_back(arg);
+    }
+    if (args.size() != 1 && args.size() != 3) {
+        cerr << usage;
+        return 1;
+    }
+
+    long long p, g, h, knownX = -1;
+    if (args.size() == 1) {
+        ElGamalKey key;
+        if (!loadElGamalKey(args[0], key)) return 1;
+        p = key.p, g = key.g, h = key.h, knownX = key.x;
+    } else {
+        p = atoll(args[0].c_str()), g = atoll(args[1].c_str()), h = atoll(args[2].c_str());
+        if (p < 3 || g <= 0 || g >= p || h <= 0 || h >= p) {
+            cerr << "need an odd prime p and 0 < g, h < p\n";
+            return 1;
+        }
+    }
+
+    ThreadPool pool(threads);
+    cout << fixed << setprecision(1);
+    auto start = chrono::steady_clock::now();
+    try {
+        ElGamalGroup group(p, pool);
+        double factorMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "p - 1 = ";
+        for (size_t i = 0; i < group.primeFactors.size(); i++)
+            cout << (i ? " * " : "") << group.primeFactors[i] << (group.multiplicity[i] > 1 ? "^" + to_string(group.multiplicity[i]) : "");
+        cout << "   (factored in " << factorMs << " ms)\n";
+
+        DlogReport rep = discreteLog(group, g, h, pool);
+        cout << "order of g: " << rep.order << (rep.order == (u64)p - 1 ? " (g generates Z_p*)" : "") << "\n";
+        int largestBits = 0;
+        for (const DlogStep& s : rep.steps) {
+            cout << setw(22) << (to_string(s.q) + (s.e > 1 ? "^" + to_string(s.e) : "")) << "  " << setw(4) << s.method
+                 << setw(16) << s.steps << " ops" << setw(12) << s.ms << " ms\n";
+            largestBits = max(largestBits, 64 - __builtin_clzll(s.q));
+        }
+        if (rep.gaveUp) {
+            cout << "search exhausted: h is a power of g, but the rho walk hit its step limit\n";
+            return 1;
+        }
+        if (!rep.found) {
+            cout << "h is not a power of g: no x exists\n";
+            return 1;
+        }
+        cout << "x = " << rep.x << "   (Pohlig-Hellman in " << rep.ms << " ms, " << pool.size() << " threads)\n";
+        if (knownX >= 0) cout << "matches the key file's x: " << ((u64)knownX % rep.order == rep.x ? "yes" : "NO") << "\n";
+        cout << "largest prime factor of the order: " << largestBits << " bits -> about 2^" << largestBits / 2
+             << " group operations to recover any x under this p\n";
+
+        if (generic) {
+            int orderBits = 64 - __builtin_clzll(rep.order);
+            if (orderBits > GENERIC_BSGS_MAX_BITS) {
+                cout << "plain BSGS skipped: the order has " << orderBits << " bits (limit " << GENERIC_BSGS_MAX_BITS << ")\n";
+            } else {
+                Montgomery mont((u64)p);
+                u64 x = 0, ops = 0;
+                auto t0 = chrono::steady_clock::now();
+                bool ok = bsgs(mont, mont.toMont((u64)g), mont.toMont((u64)h), rep.order, x, &ops);
+                cout << "plain BSGS over the whole order: x = " << (ok ? to_string(x) : "not found") << ", " << ops << " ops, "
+                     << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms\n";
+            }
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -3,11 +3,11 @@
 
     What this file does:
     - Implements basic ElGamal public-key encryption and decryption over Z_p (integers mod p).
-    - It asks the user for a prime p, selects a generator g, reads a private key x and a session key k,
+    - It asks the user for a prime p (or generates one), selects a generator g, reads a private key x and a session key k,
         then encrypts a numeric message M and decrypts it back.
 
     Important variables / mapping:
-    - p : prime modulus (user input)
+    - p : prime modulus (user input, checked with Miller–Rabin, or randomPrime from primes.h)
     - g : generator of the multiplicative group Z_p* (found by the program)
     - x : private key (user input)
     - h : public key component h = g^x mod p
@@ -18,89 +18,87 @@
     Security notes (educational; not production):
     - This is textbook ElGamal (no padding). Do NOT use this code for real communications.
     - Uses `long long` and `bits/stdc++.h` for simplicity — real implementations use big-integer libraries (GMP/OpenSSL).
-    - The program searches for a generator by factoring p-1 — practical only for small p in demos.
+    - The generator search factors p-1 once (elgamal_group.h: trial division + Pollard rho),
+        then tests candidates with one modexp per prime factor of p-1, in parallel.
+    - A p whose p-1 has only small prime factors gives x away: Elgamal_dlog.cpp
+        recovers x from h by Pohlig–Hellman on the same factorization.
+
+    Parameter file:
+        ./Elgamal_params safe 62 > params.txt
+        ./Elgamal_encryption params.txt
+    - p and g come from the file (elgamal_params.h), already validated, so there is
+        no prompt for p and no generator search. p must be below 2^62 here.
+
+    Fixed modulus:
+    - All arithmetic mod p goes through the residue type Fp (modint.h). By default it is
+        DynModInt and p is read at run time; building with -DFIXED_P=<prime> makes it
+        ModInt<FIXED_P>, so the reductions use compile-time Montgomery constants:
+            g++ -O2 -DFIXED_P=1000000007 Elgamal_encryption.cpp
 
     File structure:
-    - gcd: greatest common divisor (Euclid)
-    - power: fast modular exponentiation (square-and-multiply)
-    - modInverse: modular inverse via Extended Euclid
-    - isGenerator: tests whether g is a primitive root modulo p
+    - gcd: shared helper from modarith.h; Fp: residues mod p (modint.h)
+    - FixedBase (fixed_base.h): precomputed powers of g and h, so g^k and h^k need
+        no squarings (width FIXED_BASE_WIDTH; FixedBase<Fp>(g, w) trades memory for speed)
+    - ElGamalGroup (elgamal_group.h): p-1 factored once, isGenerator / findGenerator
+    - loadElGamalParams (elgamal_params.h): p and g from a parameter file
     - main: interactive flow (read inputs, compute keys, encrypt, decrypt)
 */
 
-#include <bits/stdc++.h>
-using namespace std;
-
-long long gcd(long long a, long long b) {
-    if (b == 0) return a;
-    return gcd(b, a % b);
-}
-
-// fast modular exponentiation
-long long power(long long a, long long b, long long mod) {
-    long long res = 1;
-    a %= mod;
-    while (b > 0) {
-        if (b & 1) res = (res * a) % mod;
-        a = (a * a) % mod;
-        b >>= 1;
-    }
-    return res;
-}
-
-// modular inverse using Extended Euclid
-long long modInverse(long long a, long long m) {
-    long long m0 = m, y = 0, x = 1;
-    if (m == 1) return 0;
-
-    while (a > 1) {
-        long long q = a / m;
-        long long t = m;
-        m = a % m, a = t;
-        t = y;
-        y = x - q * y;
-        x = t;
-    }
-
-    if (x < 0) x += m0;
-    return x;
-}
-
-// check if g is a generator of Z*p
-bool isGenerator(long long g, long long p) {
-    // p is prime, so group size = p-1
-    long long phi = p - 1;
-    vector<long long> factors;
-
-    long long n = phi;
-    for (long long i = 2; i * i <= n; i++) {
-        if (n % i == 0) {
-            factors.push_back(i);
-            while (n % i == 0) n /= i;
+#include "modint.h"
+#include "fixed_base.h"
+#include "elgamal_group.h"
+#include "elgamal_params.h"
+
+#ifdef FIXED_P
+typedef ModInt<FIXED_P> Fp;
+#else
+typedef DynModInt Fp;
+#endif
+
+// Size of a generated p (below 2^62, so every intermediate fits a long long)
+const int GENERATED_P_BITS = 62;
+
+int main(int argc, char** argv) {
+    ThreadPool pool;
+    long long p, g = 0;
+    if (argc > 1) {
+        ElGamalParams params;
+        if (!loadElGamalParams(argv[1], params)) return 1;
+        if (params.p.bitLength() > GENERATED_P_BITS) {
+            cout << "p has " << params.p.bitLength() << " bits; this demo needs at most " << GENERATED_P_BITS << ".\n";
+            return 1;
         }
-    }
-    if (n > 1) factors.push_back(n);
-
-    for (int i = 0; i < factors.size(); i++) {
-        long long f = factors[i];
-        if (power(g, phi / f, p) == 1) {
-            return false;
+        p = (long long)params.p.low();
+        g = (long long)params.g.low();
+        cout << "Loaded p = " << p << ", g = " << g << " from " << argv[1] << "\n";
+#ifdef FIXED_P
+        if (p != Fp::modulus()) {
+            cout << "p does not match the fixed modulus " << Fp::modulus() << ".\n";
+            return 1;
         }
+#endif
+    } else {
+#ifdef FIXED_P
+        p = Fp::modulus();
+        cout << "Prime p (fixed at build time) = " << p << "\n";
+#else
+        cout << "Enter a large prime p (or 0 to generate a " << GENERATED_P_BITS << "-bit one): ";
+        cin >> p;
+        if (p == 0) {
+            p = (long long)randomPrime(GENERATED_P_BITS, pool).low();
+            cout << "Generated p = " << p << "\n";
+        }
+#endif
     }
-    return true;
-}
-
-int main() {
-    long long p;
-    cout << "Enter a large prime number (p): ";
-    cin >> p;
-
-    // find generator starting from 100
-    long long g = 100;
-    while (g < p && !isGenerator(g, p)) {
-        g++;
+    if (p < 3 || !isPrime((u64)p)) {
+        cout << p << " is not an odd prime.\n";
+        return 0;
     }
-    if (g >= p) {
+    Fp::setModulus(p);
+
+    // find generator starting from 100 (p - 1 is factored once, candidates tested in parallel)
+    if (g == 0) g = ElGamalGroup(p, pool).findGenerator(100, pool);
+    if (g == 0) {
         cout << "No generator found.\n";
         return 0;
     }
@@ -126,20 +124,22 @@ int main() {
     cin >> M;
 
     // compute public key h
-    long long h = power(g, x, p);
+    Fp h = Fp(g).pow(x);
+
+    // Fixed-base tables for g and h, built once per public key (fixed_base.h)
+    FixedBase<Fp> gTable(g), hTable(h);
 
-    // Encryption
-    long long C1 = power(g, k, p);
-    long long C2 = (M * power(h, k, p)) % p;
+    // Encryption: each power is ~11 table multiplications, no squarings
+    Fp C1 = gTable.pow(k);
+    Fp C2 = Fp(M) * hTable.pow(k);
 
     cout << "\nPublic Key: (p=" << p << ", g=" << g << ", h=" << h << ")\n";
     cout << "Private Key: x = " << x << "\n";
     cout << "Ciphertext: (" << C1 << ", " << C2 << ")\n";
 
-    // Decryption
-    long long s = power(C1, x, p);
-    long long s_inv = modInverse(s, p);
-    long long decrypted = (C2 * s_inv) % p;
+    // Decryption: C2 / C1^x = C2 * C1^(p-1-x), since C1^(p-1) = 1 (no inverse needed;
+    // elgamal_decrypt.h does the same for whole ciphertext arrays)
+    Fp decrypted = C2 * C1.pow(p - 1 - x % (p - 1));
 
     cout << "\nDecrypted Message: " << decrypted << "\n";
 
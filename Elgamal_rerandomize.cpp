@@ -0,0 +1,170 @@
+/*
+    Elgamal_rerandomize.cpp — rerandomize or shuffle a ciphertext file from a precomputed pool
+
+    Purpose:
+    - Elgamal_Product_Rerandomization.cpp rerandomizes one ciphertext by multiplying
+        it with an encryption of 1, (g^k, h^k). This program does it for a whole
+        ciphertext file (elgamal_file.h) and splits the work the way a mix-net
+        server would: the (g^k, h^k) pairs are computed ahead of time by a
+        RerandomizationPool (elgamal_rerandomize.h), and the online step is two
+        modular multiplications per ciphertext.
+
+    Usage:
+        ./Elgamal_batch encrypt key.txt in.egc messages.txt
+        ./Elgamal_rerandomize <key file> <in.egc> <out.egc> [--shuffle] [--pool N] [--threads N]
+        ./Elgamal_batch decrypt key.txt out.egc   (same plaintexts as in.egc)
+    - A public key file is enough. --shuffle permutes the ciphertexts first (one
+        mix-net step; the plaintexts then come out as the same multiset, in a new
+        order). --pool sets the pool capacity (default 65536 pairs, rounded up to a
+        power of two like every BoundedQueue), --threads the number of producer
+        threads (default: all cores). Refills start below a quarter of it.
+    - Error records (c1 = 0) and values that are not below p are written as error
+        records (0, 0).
+    - With --shuffle the whole file is one mix-net step (RerandomizationPool::shuffle),
+        so it is served from the pool only when --pool is at least the file size;
+        the rest shows up as misses.
+    - When the key file holds x, both files are decrypted (elgamal_decrypt.h) and
+        the plaintexts compared, as a multiset after a shuffle; a mismatch exits 1.
+
+    Flow:
+    1) Baseline: rerandomize a sample with fresh pairs computed inline from
+        FixedBase tables (what Elgamal_batch does per encryption).
+    2) Cut the file into pool-sized chunks. Per chunk: offline phase
+        (waitUntilFull), then the online phase (rerandomize), timed separately.
+        With --shuffle: one offline phase, then shuffle() over the whole file.
+    3) Print online cost per ciphertext against the inline baseline, plus the pool
+        metrics: depth, hits / misses, refill rounds and refill latency.
+    4) With the private key: check that the plaintexts of the pool output and of
+        the inline sample are unchanged.
+*/
+
+#include "elgamal_rerandomize.h"
+#include "elgamal_decrypt.h"
+#include "fixed_base.h"
+
+typedef DynModInt Fp;
+
+const size_t INLINE_SAMPLE = 20000;   // ciphertexts rerandomized with inline pairs for the baseline
+
+int main(int argc, char** argv) {
+    string usage = "usage: Elgamal_rerandomize <key file> <in.egc> <out.egc> [--shuffle] [--pool N] [--threads N]\n"
+                   "  --pool N is rounded up to a power of two\n";
+    if (argc < 4) {
+        cerr << usage;
+        return 1;
+    }
+    bool shuffle = false;
+    size_t capacity = 1 << 16;
+    unsigned threads = thread::hardware_concurrency();
+    for (int i = 4; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--shuffle") shuffle = true;
+        else if (arg == "--pool" && i + 1 < argc) capacity = (size_t)max(2LL, atoll(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+        else {
+            cerr << usage;
+            return 1;
+        }
+    }
+
+    ElGamalKey key;
+    if (!loadElGamalKey(argv[1], key)) return 1;
+    CipherFileReader file;
+    if (!file.open(argv[2])) return 1;
+    const CipherFileHeader& hdr = file.header();
+    if ((long long)hdr.p != key.p || (long long)hdr.g != key.g || (long long)hdr.h != key.h) {
+        cerr << argv[2] << " was encrypted under a different key\n";
+        return 1;
+    }
+
+    u64 p = (u64)key.p, errors = 0;
+    vector<CipherRecord> cts(file.records(), file.records() + file.count());
+    for (CipherRecord& r : cts)
+        if (r.c1 == 0 || r.c1 >= p || r.c2 >= p) r = CipherRecord{0, 0}, errors++;   // 0 * pair stays 0
+
+    vector<CipherRecord> original = cts;
+
+    // 1) baseline: the first INLINE_SAMPLE ciphertexts rerandomized with fresh pairs computed inline
+    Fp::setModulus(key.p);
+    FixedBase<Fp> gTable(key.g), hTable(key.h);
+    mt19937_64 rng(random_device{}());
+    uniform_int_distribution<long long> pickK(1, key.p - 2);
+    vector<CipherRecord> inlineOut(cts.begin(), cts.begin() + min(INLINE_SAMPLE, cts.size()));
+    auto start = chrono::steady_clock::now();
+    for (CipherRecord& r : inlineOut) {
+        u64 k = (u64)pickK(rng);
+        r.c1 = (u64)(Fp((long long)r.c1) * gTable.pow(k)).value();
+        r.c2 = (u64)(Fp((long long)r.c2) * hTable.pow(k)).value();
+    }
+    double inlineNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / max<size_t>(inlineOut.size(), 1);
+
+    // 2) offline / online phases
+    threads = max(1u, threads);
+    size_t rounded = 2;   // the queue's own capacity, so the low-water mark is a quarter of what it holds
+    while (rounded < capacity) rounded <<= 1;
+    size_t lowWater = rounded / 4;
+    RerandomizationPool pool(key, rounded, lowWater, threads);
+    double offlineSeconds = 0, onlineSeconds = 0;
+    auto phases = [&](auto online) {
+        auto t0 = chrono::steady_clock::now();
+        pool.waitUntilFull();
+        auto t1 = chrono::steady_clock::now();
+        online();
+        auto t2 = chrono::steady_clock::now();
+        offlineSeconds += chrono::duration<double>(t1 - t0).count();
+        onlineSeconds += chrono::duration<double>(t2 - t1).count();
+    };
+    if (shuffle) {
+        phases([&] { pool.shuffle(cts, rng); });
+    } else {
+        for (size_t lo = 0; lo < cts.size(); lo += pool.capacity())
+            phases([&] { pool.rerandomize(cts.data() + lo, min(pool.capacity(), cts.size() - lo)); });
+    }
+
+    CipherFileWriter writer;
+    if (!writer.open(argv[3], key) || !writer.append(cts.data(), cts.size()) || !writer.close()) {
+        cerr << "write to " << argv[3] << " failed\n";
+        return 1;
+    }
+
+    // 3) report
+    RefillStats s = pool.stats();
+    double onlineNs = onlineSeconds * 1e9 / max<size_t>(cts.size(), 1);
+    cerr << fixed << setprecision(1);
+    cerr << (shuffle ? "shuffled and rerandomized " : "rerandomized ") << cts.size() << " ciphertexts (" << errors
+         << " error records) into " << argv[3] << "\n";
+    cerr << "inline pair (FixedBase g^k, h^k): " << inlineNs << " ns/ciphertext\n";
+    cerr << "online (pool, 2 multiplications):  " << onlineNs << " ns/ciphertext, " << setprecision(3) << onlineSeconds
+         << " s total";
+    if (onlineNs > 0) cerr << " (" << setprecision(1) << inlineNs / onlineNs << "x faster)";
+    cerr << "\n";
+    cerr << "offline waits: " << setprecision(3) << offlineSeconds << " s, " << threads << " producer threads\n";
+    cerr << "pool: capacity " << pool.capacity() << ", low water " << lowWater << ", depth " << s.depth << ", hits " << s.hits
+         << ", misses " << s.misses << ", generated " << s.generated << "\n";
+    cerr << "refill: initial fill " << setprecision(2) << s.initialFillMs << " ms, " << s.refills << " rounds, latency last "
+         << s.lastRefillMs << " ms / mean " << s.meanRefillMs << " ms / max " << s.maxRefillMs << " ms\n";
+
+    // 4) the plaintexts must not change (only their order, with --shuffle)
+    if (!key.hasPrivate()) {
+        cerr << "plaintext check skipped: public key only\n";
+        return 0;
+    }
+    ThreadPool workers(threads);
+    auto decryptAll = [&](const vector<CipherRecord>& v) {
+        vector<u64> m(v.size());
+        decryptBatch(p, (u64)key.x, v.data(), v.size(), m.data(), workers);
+        return m;
+    };
+    vector<u64> before = decryptAll(original), after = decryptAll(cts), inlineAfter = decryptAll(inlineOut);
+    bool inlineOk = equal(inlineAfter.begin(), inlineAfter.end(), before.begin());
+    if (shuffle) {
+        sort(before.begin(), before.end());
+        sort(after.begin(), after.end());
+    }
+    if (before != after || !inlineOk) {
+        cerr << "plaintext check FAILED: rerandomization changed a plaintext\n";
+        return 1;
+    }
+    cerr << "plaintext check: all " << cts.size() << " plaintexts unchanged" << (shuffle ? " (as a multiset)" : "") << "\n";
+    return 0;
+}
@@ -8,11 +8,13 @@
         and no hashing/padding of messages).
 
     High-level flow:
-    1) Read a prime p and find a generator g of Z_p*.
+    1) Read a prime p (or generate one with randomPrime) and find a generator g of Z_p*
+        (elgamal_group.h: p-1 is factored once, candidates are tested in parallel).
     2) Read private key x and compute public key y = g^x mod p.
     3) Choose a random-like k with gcd(k, p-1) = 1, compute r = g^k mod p.
     4) Compute s = k^{-1} * (M - x*r) mod (p-1).
-    5) Signature is (r, s). Verify by checking g^M ?= y^r * r^s (mod p).
+    5) Signature is (r, s). Verify by checking g^M ?= y^r * r^s (mod p), with the
+        right side as one Shamir/Straus double exponentiation (elgamal_verify.h).
 
     Variable mapping:
     - p : prime modulus
@@ -23,82 +25,176 @@
     - M : integer message to sign (in practice, sign a hash(M))
     - r, s : signature components
 
+    File mode (hash-then-sign):
+        ./Elgamal_signature sign <p> <x> file... > sigs.txt
+        ./Elgamal_signature verify <p> <y> sigs.txt
+    - M = SHA-256(file) mod (p-1) (sha256.h: streaming, mmap, SHA-NI when available).
+    - sigs.txt has one "<r> <s>  <path>" line per file; every signature gets
+        its own random k. g is found the same way as in the interactive demo.
+    - Files are hashed in parallel on a ThreadPool; verify then cuts the
+        signatures into one part per worker and checks each part with one
+        randomized batch screen (elgamal_verify.h) on the same pool, bisecting
+        only the parts that fail. For a p where the screen would need many
+        product tests (small factors in (p-1)/2), every signature is checked on
+        its own, still on the pool. A line of sigs.txt that does not parse is kept as
+        a FAILED (malformed) entry. The exit status is 1 when any entry fails.
+
     Notes:
     - Uses long long for simplicity: only for tiny toy primes. Real systems use bignums.
     - Do not reuse k between signatures: reuse leaks x.
 */
 
-#include <bits/stdc++.h>
-using namespace std;
+#include "elgamal_group.h"
+#include "sha256.h"
+#include "elgamal_verify.h"
 
-long long gcd(long long a, long long b) {
-    if (b == 0) return a;
-    return gcd(b, a % b);
-}
+// Size of a generated p (below 2^62, so every intermediate fits a long long)
+const int GENERATED_P_BITS = 62;
 
-// fast modular exponentiation
-long long power(long long a, long long b, long long mod) {
-    long long res = 1;
-    a %= mod;
-    while (b > 0) {
-        if (b & 1) res = (res * a) % mod;
-        a = (a * a) % mod;
-        b >>= 1;
-    }
-    return res;
+// Smallest generator from 100 up, as in the interactive demo; 0 if there is none.
+// p - 1 is factored once (elgamal_group.h) and the candidates are tested in parallel.
+long long findGenerator(long long p, ThreadPool& pool) {
+    return ElGamalGroup(p, pool).findGenerator(100, pool);
 }
 
-// modular inverse using Extended Euclid
-long long modInverse(long long a, long long m) {
-    long long m0 = m, y = 0, x = 1;
-    if (m == 1) return 0;
-
-    while (a > 1) {
-        long long q = a / m;
-        long long t = m;
-        m = a % m, a = t;
-        t = y;
-        y = x - q * y;
-        x = t;
-    }
-
-    if (x < 0) x += m0;
-    return x;
+// SHA-256 digest as a number mod m
+long long digestMod(const Sha256Digest& d, long long m) {
+    u64 x = 0;
+    for (uint8_t b : d) x = (u64)(((u128)x << 8 | b) % (u64)m);
+    return (long long)x;
 }
 
-// check if g is generator of Zp*
-bool isGenerator(long long g, long long p) {
-    long long phi = p - 1;
-    vector<long long> factors;
-
-    long long n = phi;
-    for (long long i = 2; i * i <= n; i++) {
-        if (n % i == 0) {
-            factors.push_back(i);
-            while (n % i == 0) n /= i;
+int fileMode(const string& mode, long long p, long long key, const vector<string>& args) {
+    if (p < 5 || !isPrime((u64)p) || p >= (1LL << 62)) {
+        cerr << p << " is not an odd prime below 2^62\n";
+        return 1;
+    }
+    ThreadPool pool;
+    long long g = findGenerator(p, pool);
+    if (g == 0) {
+        cerr << "No generator found.\n";
+        return 1;
+    }
+    vector<string> paths;
+    vector<long long> rs, ss;
+    vector<char> malformed;   // verify: lines that do not parse, kept and reported as FAILED
+    if (mode == "sign") {
+        paths = args;
+    } else {
+        ifstream in(args.empty() ? "" : args[0]);
+        if (!in) {
+            cerr << "usage: Elgamal_signature verify <p> <y> sigs.txt\n";
+            return 1;
+        }
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            size_t gap = line.find("  ");
+            long long r = 0, s = 0;
+            string extra;
+            bool ok = gap != string::npos;
+            if (ok) {
+                istringstream fields(line.substr(0, gap));
+                ok = (fields >> r >> s) && !(fields >> extra);
+            }
+            if (!ok) cerr << "malformed line: " << line << "\n";
+            rs.push_back(r);
+            ss.push_back(s);
+            paths.push_back(ok ? line.substr(gap + 2) : line);
+            malformed.push_back(!ok);
         }
     }
-    if (n > 1) factors.push_back(n);
-
-    for (int i = 0; i < factors.size(); i++) {
-        long long f = factors[i];
-        if (power(g, phi / f, p) == 1) {
-            return false;
+    malformed.resize(paths.size(), 0);
+
+    auto start = chrono::steady_clock::now();
+    vector<Sha256Digest> digests;
+    vector<char> readable;
+    vector<string> toHash = paths;
+    for (size_t i = 0; i < paths.size(); i++)
+        if (malformed[i]) toHash[i].clear();   // not a file name: not hashed
+    u64 bytes = sha256Files(toHash, pool, digests, readable);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << "hashed " << paths.size() << " files, " << fixed << setprecision(1) << bytes / 1e6 << " MB in "
+         << setprecision(3) << seconds << " s (" << setprecision(2) << bytes / max(seconds, 1e-9) / 1e9 << " GB/s, "
+         << (cpuHasShaNi() ? "SHA-NI" : "portable SHA-256") << ")\n";
+
+    bool allOk = true;
+    if (mode == "sign") {
+        long long x = key;
+        cerr << "Public Key: (p=" << p << ", g=" << g << ", y=" << power(g, x, p) << ")\n";
+        mt19937_64 rng(random_device{}());
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (!readable[i]) {
+                cerr << paths[i] << ": cannot read\n";
+                allOk = false;
+                continue;
+            }
+            long long M = digestMod(digests[i], p - 1), r, s;
+            do {
+                long long k;
+                do {
+                    k = 2 + (long long)(rng() % (u64)(p - 3));
+                } while (gcd(k, p - 1) != 1);
+                r = power(g, k, p);
+                s = mulMod(modInverse(k, p - 1), ((M - mulMod(x, r, p - 1)) % (p - 1) + (p - 1)) % (p - 1), p - 1);
+            } while (s == 0);
+            cout << r << " " << s << "  " << paths[i] << "\n";
         }
+        return allOk ? 0 : 1;
     }
 
-    return true;
+    long long y = key;
+    vector<long long> ms, batchR, batchS;
+    vector<size_t> at;   // index into paths of every readable file
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (malformed[i] || !readable[i]) continue;
+        at.push_back(i);
+        ms.push_back(digestMod(digests[i], p - 1));
+        batchR.push_back(rs[i]);
+        batchS.push_back(ss[i]);
+    }
+    ElGamalVerifier verifier(p, g, y);
+    BatchVerifyResult res = verifier.verifyBatch(ms, batchR, batchS, pool);
+    vector<char> pass(paths.size(), 0);
+    for (size_t i : at) pass[i] = 1;
+    for (size_t j : res.failures) pass[at[j]] = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        cout << paths[i] << ": "
+             << (malformed[i] ? "FAILED (malformed)" : !readable[i] ? "FAILED (cannot read)" : pass[i] ? "OK" : "FAILED") << "\n";
+        failed += !pass[i];
+    }
+    cerr << failed << " of " << paths.size() << " signatures failed (" << res.screens << " batch tests)\n";
+    return failed ? 1 : 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        string mode = argv[1];
+        if ((mode != "sign" && mode != "verify") || argc < 5) {
+            cerr << "usage: Elgamal_signature                              (interactive demo)\n"
+                    "       Elgamal_signature sign <p> <x> file...         (hash-then-sign, signatures to stdout)\n"
+                    "       Elgamal_signature verify <p> <y> sigs.txt\n";
+            return 1;
+        }
+        return fileMode(mode, atoll(argv[2]), atoll(argv[3]), vector<string>(argv + 4, argv + argc));
+    }
+
+    ThreadPool pool;
     long long p;
-    cout << "Enter a large prime p: ";
+    cout << "Enter a large prime p (or 0 to generate a " << GENERATED_P_BITS << "-bit one): ";
     cin >> p;
+    if (p == 0) {
+        p = (long long)randomPrime(GENERATED_P_BITS, pool).low();
+        cout << "Generated p = " << p << "\n";
+    } else if (p < 3 || !isPrime((u64)p)) {
+        cout << p << " is not an odd prime.\n";
+        return 0;
+    }
 
     // find generator starting from 100
-    long long g = 100;
-    while (g < p && !isGenerator(g, p)) g++;
-    if (g >= p) {
+    long long g = findGenerator(p, pool);
+    if (g == 0) {
         cout << "No generator found.\n";
         return 0;
     }
@@ -129,15 +225,15 @@ int main() {
     // signature generation
     long long r = power(g, k, p);
     long long k_inv = modInverse(k, p - 1);
-    long long s = (k_inv * ((M - (x * r) % (p - 1)) + (p - 1))) % (p - 1); // ensure non-negative
+    long long s = mulMod(k_inv, ((M - mulMod(x, r, p - 1)) % (p - 1) + (p - 1)) % (p - 1), p - 1); // ensure non-negative
 
     cout << "\nPublic Key: (p=" << p << ", g=" << g << ", y=" << y << ")\n";
     cout << "Private Key: x = " << x << "\n";
     cout << "Signature: (r=" << r << ", s=" << s << ")\n";
 
-    // verification
+    // verification: y^r * r^s as one interleaved (Shamir) exponentiation
     long long v1 = power(g, M, p);
-    long long v2 = (power(y, r, p) * power(r, s, p)) % p;
+    long long v2 = ElGamalVerifier(p, g, y).rightSide(r, s);
 
     cout << "\nVerification:\n";
     cout << "g^M mod p = " << v1 << "\n";
@@ -0,0 +1,154 @@
+/*
+    Elgamal_tally.cpp — homomorphic yes/no tally over ElGamal ciphertexts
+
+    Purpose:
+    - Elgamal_Product_Rerandomization.cpp shows (in comments) that multiplying two
+        ciphertexts componentwise multiplies the plaintexts. This program does that
+        for millions of ballots at once: every ballot encrypts g^vote (vote 0 or 1),
+        the product of all ballots encrypts g^(yes votes), and only that one
+        aggregate ciphertext is decrypted.
+
+    Usage:
+        ./Elgamal_batch keygen > key.txt
+        ./Elgamal_tally cast <key file> <ballots.egc> <voters> [--threads N]
+        ./Elgamal_tally count <key file> <ballots.egc> [--threads N]
+    - cast writes random ballots to a ciphertext file (elgamal_file.h) through the
+        same kind of pipeline as Elgamal_batch, and prints the true yes count to
+        stderr so the tally can be checked. A public key file is enough.
+    - count maps the file, transposes it into SoA buffers of c1 / c2, multiplies
+        them with the parallel tree reduction of elgamal_tally.h, decrypts the
+        aggregate and finds the yes count t from g^t by stepping t = 0, 1, 2, ...
+        (at most one multiplication per ballot). Needs the private key.
+    - Any ciphertext file works with count (for example Elgamal_batch output): the
+        product of the plaintexts is always printed, the yes count only when it is
+        a power g^t with t <= the number of ballots.
+*/
+
+#include "elgamal_tally.h"
+#include "fixed_base.h"
+
+typedef DynModInt Fp;
+
+const size_t BALLOTS_PER_BATCH = 4096;   // ballots encrypted per worker task
+const size_t BATCHES_IN_FLIGHT = 4;      // per worker thread, bounds memory use
+
+struct BallotBatch {
+    size_t count = 0;
+    vector<CipherRecord> out;
+};
+
+int cast(const ElGamalKey& key, const string& outPath, u64 voters, ThreadPool& pool) {
+    CipherFileWriter writer;
+    if (!writer.open(outPath, key)) {
+        cerr << "cannot create " << outPath << "\n";
+        return 1;
+    }
+    FixedBase<Fp> gTable(key.g), hTable(key.h);
+    Fp g(key.g);
+    long long p = key.p;
+    u64 issued = 0;
+    atomic<u64> yes(0);
+
+    auto read = [&](BallotBatch& batch) {
+        batch.count = (size_t)min<u64>(BALLOTS_PER_BATCH, voters - issued);
+        issued += batch.count;
+        return batch.count > 0;
+    };
+    auto work = [&](BallotBatch& batch) {
+        static thread_local mt19937_64 rng(random_device{}());
+        uniform_int_distribution<long long> pickK(1, p - 2);
+        batch.out.resize(batch.count);
+        u64 localYes = 0;
+        for (CipherRecord& r : batch.out) {
+            bool vote = rng() & 1;
+            u64 k = (u64)pickK(rng);
+            Fp hk = hTable.pow(k);
+            r.c1 = (u64)gTable.pow(k).value();
+            r.c2 = (u64)(vote ? g * hk : hk).value();   // g^vote * h^k
+            localYes += vote;
+        }
+        yes += localYes;
+    };
+    auto write = [&](BallotBatch& batch) { writer.append(batch.out.data(), batch.out.size()); };
+
+    auto start = chrono::steady_clock::now();
+    orderedPipeline<BallotBatch>(pool, BATCHES_IN_FLIGHT * pool.size(), read, work, write);
+    bool ok = writer.close();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!ok) {
+        cerr << "write to " << outPath << " failed\n";
+        return 1;
+    }
+    cerr << "cast " << voters << " ballots (" << yes << " yes) in " << fixed << setprecision(2) << seconds << " s ("
+         << setprecision(0) << voters / max(seconds, 1e-9) << " ballots/s, " << pool.size() << " threads)\n";
+    return 0;
+}
+
+int count(const ElGamalKey& key, const string& inPath, ThreadPool& pool) {
+    if (!key.hasPrivate()) {
+        cerr << "count needs a key file with x\n";
+        return 1;
+    }
+    CipherFileReader file;
+    if (!file.open(inPath)) return 1;
+    const CipherFileHeader& hdr = file.header();
+    if ((long long)hdr.p != key.p || (long long)hdr.g != key.g || (long long)hdr.h != key.h) {
+        cerr << inPath << " was encrypted under a different key\n";
+        return 1;
+    }
+    u64 n = file.count();
+    Montgomery mont((u64)key.p);
+
+    auto start = chrono::steady_clock::now();
+    size_t invalid = 0;
+    CiphertextSoA ballots = loadCiphertexts(file.records(), n, (u64)key.p, pool, invalid);
+    auto loaded = chrono::steady_clock::now();
+    CipherRecord total = aggregateCiphertexts(mont, ballots, pool);
+    auto reduced = chrono::steady_clock::now();
+
+    // the only decryption: m = c2 / c1^x
+    Fp product = Fp((long long)total.c2) / Fp((long long)total.c1).pow(key.x);
+    cout << "ballots: " << n << " (" << invalid << " invalid, counted as encryptions of 1)\n";
+    cout << "product of plaintexts: " << product << "\n";
+
+    Fp g(key.g), step(1);
+    u64 t = 0;
+    while (t <= n && step != product) step *= g, t++;
+    if (t <= n) cout << "yes votes: " << t << " of " << n - invalid << "\n";
+    else cout << "the product is not g^t for any t <= " << n << " (not a yes/no ballot file?)\n";
+
+    auto secs = [](chrono::steady_clock::duration d) { return chrono::duration<double>(d).count(); };
+    double reduceSeconds = secs(reduced - loaded);
+    cerr << "load " << fixed << setprecision(3) << secs(loaded - start) << " s, reduce " << reduceSeconds << " s ("
+         << setprecision(0) << n / max(reduceSeconds, 1e-9) << " ciphertexts/s), decrypt + search " << setprecision(3)
+         << secs(chrono::steady_clock::now() - reduced) << " s, " << pool.size() << " threads\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    string usage = "usage: Elgamal_tally cast <key file> <ballots.egc> <voters> [--threads N]\n"
+                   "       Elgamal_tally count <key file> <ballots.egc> [--threads N]\n";
+    string mode = argc > 1 ? argv[1] : "";
+    bool casting = mode == "cast";
+    if ((!casting && mode != "count") || argc < (casting ? 5 : 4)) {
+        cerr << usage;
+        return 1;
+    }
+    unsigned threads = 0;
+    for (int i = casting ? 5 : 4; i < argc; i++)
+        if (string(argv[i]) == "--threads" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+
+    ElGamalKey key;
+    if (!loadElGamalKey(argv[2], key)) return 1;
+    Fp::setModulus(key.p);   // before any worker starts (DynModInt keeps one shared modulus)
+    ThreadPool pool(threads);
+    if (casting) {
+        long long voters = atoll(argv[4]);
+        if (voters < 1) {
+            cerr << "the number of voters must be positive\n";
+            return 1;
+        }
+        return cast(key, argv[3], (u64)voters, pool);
+    }
+    return count(key, argv[3], pool);
+}
@@ -19,40 +19,32 @@
         for production.
     - The program assumes inputs are valid (p prime, a and b define a non-singular
         curve, M is a point on the curve). No exhaustive validation is performed.
+
+    Field arithmetic:
+    - Coordinates are residues of type Fp (modint.h): DynModInt with p read at run
+        time, or ModInt<FIXED_P> when built with -DFIXED_P=<odd prime>, which turns
+        every reduction and inverse in add() into compile-time-constant multiply/shift code:
+            g++ -O2 -DFIXED_P=10007 Elliptic_curve_encryption.cpp
+    - Slopes divide through Fp::inv (binary extended GCD), so p must be prime.
 */
 
-#include <bits/stdc++.h>
-using namespace std;
+#include "modint.h"
+
+#ifdef FIXED_P
+typedef ModInt<FIXED_P> Fp;
+#else
+typedef DynModInt Fp;
+#endif
 
 struct Point {
-    long long x, y;
+    Fp x, y;
     bool inf;
-    Point() { x = y = 0; inf = true; }
-    Point(long long _x, long long _y) { x = _x; y = _y; inf = false; }
+    Point() { inf = true; }
+    Point(Fp _x, Fp _y) { x = _x; y = _y; inf = false; }
 };
 
-long long mod(long long a, long long p) {
-    long long r = a % p;
-    if (r < 0) r += p;
-    return r;
-}
-
-long long modInverse(long long a, long long p) {
-    long long m0 = p, y = 0, x = 1;
-    if (p == 1) return 0;
-    while (a > 1) {
-        long long q = a / p;
-        long long t = p;
-        p = a % p, a = t;
-        t = y;
-        y = x - q * y;
-        x = t;
-    }
-    if (x < 0) x += m0;
-    return x;
-}
-
-long long a, b, p;
+long long p;
+Fp a, b;
 
 // Elliptic curve point addition: returns P + Q over the field modulo p.
 // Handles special cases: identity point, point doubling, and inverse pairs.
@@ -62,21 +54,17 @@ Point add(Point P, Point Q) {
     // If P and Q are inverses of each other (same x, y = -y), return infinity.
     if (P.x == Q.x && (P.y != Q.y || P.y == 0)) return Point(); 
 
-    long long lambda;
+    Fp lambda;
     if (P.x == Q.x && P.y == Q.y) {
         // Point doubling: lambda = (3*x^2 + a) / (2*y)
-        long long num = mod(3 * P.x * P.x + a, p);
-        long long den = modInverse(mod(2 * P.y, p), p);
-        lambda = mod(num * den, p);
+        lambda = (3 * P.x * P.x + a) / (2 * P.y);
     } else {
         // Point addition: lambda = (y2 - y1) / (x2 - x1)
-        long long num = mod(Q.y - P.y, p);
-        long long den = modInverse(mod(Q.x - P.x, p), p);
-        lambda = mod(num * den, p);
+        lambda = (Q.y - P.y) / (Q.x - P.x);
     }
 
-    long long xr = mod(lambda * lambda - P.x - Q.x, p);
-    long long yr = mod(lambda * (P.x - xr) - P.y, p);
+    Fp xr = lambda * lambda - P.x - Q.x;
+    Fp yr = lambda * (P.x - xr) - P.y;
 
     return Point(xr, yr);
 }
@@ -94,18 +82,29 @@ Point multiply(Point P, long long k) {
 
 Point findBasePoint() {
     for (long long x = 0; x < p; x++) {
-        long long rhs = mod((x * x % p * x % p + a * x + b), p);
+        Fp fx = x;
+        Fp rhs = fx * fx * fx + a * fx + b;
         for (long long y = 0; y < p; y++) {
-            if (mod(y * y, p) == rhs)
-                return Point(x, y);
+            if (Fp(y) * Fp(y) == rhs)
+                return Point(fx, Fp(y));
         }
     }
     return Point(); 
 }
 
 int main() {
+#ifdef FIXED_P
+    p = Fp::modulus();
+    cout << "Prime p (fixed at build time) = " << p << "\n";
+#else
     cout << "Enter prime p: ";
     cin >> p;
+    if (p < 3 || p % 2 == 0) {
+        cout << "p must be an odd prime.\n";
+        return 0;
+    }
+    Fp::setModulus(p);
+#endif
     cout << "Enter curve parameters a and b for y^2 = x^3 + ax + b mod p:\n";
     cin >> a >> b;
     // Find a curve point to use as base G (brute-force search)
@@ -146,7 +145,7 @@ int main() {
     // Decryption: compute x*C1 and subtract from C2 (subtract by adding negation)
     Point xC1 = multiply(C1, x);
     Point negX = xC1;
-    negX.y = mod(-negX.y, p); 
+    negX.y = -negX.y;
 
     Point decrypted = add(C2, negX);
 
@@ -0,0 +1,273 @@
+/*
+    RSA_batch.cpp — non-interactive RSA over streams of records
+
+    Purpose:
+    - RSA_encryption.cpp / RSA_signature.cpp prompt for one number at a time.
+        This program runs the same textbook operations over a whole file (or
+        stdin) of records, so millions of values can be processed in one run.
+
+    Usage:
+        ./RSA_batch keygen <bits> > key.txt
+        ./RSA_batch encrypt|decrypt|sign|verify <key.txt> [input|-] [--binary] [--threads N] > output
+
+    Key file (written by keygen; "name value" lines, '#' comments):
+        n <modulus>
+        e <public exponent>
+        prime <p>        one line per prime (2-4); needed for decrypt / sign only
+    - encrypt and verify only need n and e, so a public key file is just those two lines.
+
+    Records:
+    - text (default): one decimal or 0x-hex number per non-empty line; one
+        decimal result per line, in input order.
+    - --binary: each record is a 4-byte big-endian length L followed by L bytes
+        of big-endian unsigned integer; results use the same framing.
+    - verify: a record is a pair "M S" (two numbers on a line, or two frames);
+        the result is "valid" / "invalid" (text) or a 1-byte frame 1 / 0.
+    - A record that does not parse, is not below n, or (binary) has a frame
+        longer than n's byte length plus FRAME_SLACK produces "error"
+        (text) or a record with length 0xFFFFFFFF and no payload (binary), so
+        the output lines up with the input.
+
+    Pipeline (orderedPipeline, thread_pool.h):
+        reader (this thread) -> batches of RECORDS_PER_BATCH -> worker pool
+            -> writer thread, which emits batches strictly in input order
+    - Workers format their batch's output themselves; the writer only copies
+        bytes to stdout. Output is block-buffered (no per-record flush).
+    - encrypt runs each batch through batchPower (simd_modexp.h); decrypt and
+        sign use the CRT key with every leg batched the same way; verify runs
+        batchVerify (rsa_batch_verify.h) per batch: S^e one by one for a short e,
+        otherwise a randomized screen that only bisects batches that fail.
+    - A summary (records, errors, throughput) goes to stderr.
+*/
+
+#include "primes.h"
+#include "rsa_key.h"
+#include "rsa_batch_verify.h"
+
+const size_t RECORDS_PER_BATCH = 256;   // records handed to a worker at once
+const size_t VERIFY_BATCH = 4096;       // verify batches are larger: the product test pays off with size
+const size_t BATCHES_IN_FLIGHT = 4;     // per worker thread, bounds memory use
+
+struct RecordBatch {
+    vector<BigInt> values;
+    vector<BigInt> sigs;   // verify mode: the signature of each value
+    vector<char> valid;
+    string out;
+};
+
+// Big-endian unsigned bytes -> BigInt
+BigInt fromBytes(const string& bytes) {
+    vector<u64> limbs((bytes.size() + 7) / 8, 0);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        size_t pos = bytes.size() - 1 - i;   // byte significance
+        limbs[pos / 8] |= (u64)(unsigned char)bytes[i] << (8 * (pos % 8));
+    }
+    return BigInt::fromLimbs(limbs);
+}
+
+// BigInt >= 0 -> big-endian unsigned bytes (empty for 0)
+string toBytes(const BigInt& x) {
+    int len = (x.bitLength() + 7) / 8;
+    string bytes(len, '\0');
+    for (int pos = 0; pos < len; pos++) bytes[len - 1 - pos] = (char)(x.mag[pos / 8] >> (8 * (pos % 8)));
+    return bytes;
+}
+
+const u64 ERROR_FRAME = 0xFFFFFFFF;   // binary length marking a failed record
+const size_t FRAME_SLACK = 8;         // leading zero bytes allowed past the key's byte length
+
+void appendFrame(string& out, const string& payload, u64 len) {
+    for (int s = 24; s >= 0; s -= 8) out += (char)(len >> s);
+    out += payload;
+}
+
+int keygen(int bits) {
+    if (bits < 16 || bits > 16384) {
+        cerr << "key size must be between 16 and 16384 bits\n";
+        return 1;
+    }
+    ThreadPool pool;
+    BigInt p = randomPrime(bits / 2, pool), q;
+    do {
+        q = randomPrime(bits - bits / 2, pool);
+    } while (q == p);
+    BigInt phi = (p - 1) * (q - 1), e = 65537;
+    while (gcd(e, phi) != BigInt(1)) e += 2;
+    cout << "# RSA key, " << bits << " bits (RSA_batch keygen)\n";
+    cout << "n " << p * q << "\ne " << e << "\nprime " << p << "\nprime " << q << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);
+    string usage = "usage: RSA_batch keygen <bits>\n"
+                   "       RSA_batch encrypt|decrypt|sign|verify <key file> [input|-] [--binary] [--threads N]\n";
+    if (argc < 3) {
+        cerr << usage;
+        return 1;
+    }
+    string mode = argv[1];
+    if (mode == "keygen") return keygen(atoi(argv[2]));
+    if (mode != "encrypt" && mode != "decrypt" && mode != "sign" && mode != "verify") {
+        cerr << usage;
+        return 1;
+    }
+
+    string inputPath = "-";
+    bool binary = false;
+    unsigned threads = 0;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--binary") binary = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+        else inputPath = arg;
+    }
+
+    RSAKeyFile kf;
+    if (!loadRSAKeyFile(argv[2], kf)) return 1;
+    bool verify = mode == "verify";
+    bool isPublic = mode == "encrypt" || verify;
+    unique_ptr<RSAPrivateKey> key;
+    if (!isPublic) {
+        if (kf.primes.size() < 2 || kf.primes.size() > 4) {
+            cerr << mode << " needs a key file with 2-4 prime lines\n";
+            return 1;
+        }
+        key.reset(new RSAPrivateKey(kf.primes, kf.e));
+        if (key->n != kf.n) {
+            cerr << "n does not match the product of the primes\n";
+            return 1;
+        }
+    }
+
+    ifstream file;
+    if (inputPath != "-") {
+        file.open(inputPath, ios::binary);
+        if (!file) {
+            cerr << "cannot open " << inputPath << "\n";
+            return 1;
+        }
+    }
+    istream& in = inputPath == "-" ? cin : file;
+
+    ThreadPool pool(threads);
+    u64 records = 0;
+    atomic<u64> errors(0), rejected(0);
+    bool truncated = false;
+
+    size_t perRecord = verify ? 2 : 1;
+    size_t batchRecords = verify ? VERIFY_BATCH : RECORDS_PER_BATCH;
+
+    // One binary frame into v (ok = false for an error frame); false at end of input.
+    // Oversized frames are skipped without buffering, so a bad header cannot allocate 4 GB.
+    size_t maxFrame = (size_t)(kf.n.bitLength() + 7) / 8 + FRAME_SLACK;
+    auto readFrame = [&](BigInt& v, bool& ok) {
+        unsigned char hdr[4];
+        if (!in.read((char*)hdr, 4)) {
+            truncated |= in.gcount() != 0;
+            return false;
+        }
+        size_t len = (size_t)hdr[0] << 24 | (size_t)hdr[1] << 16 | (size_t)hdr[2] << 8 | hdr[3];
+        if (len == ERROR_FRAME) {
+            ok = false;   // a failed record from an earlier run passes through as an error
+            return true;
+        }
+        if (len > maxFrame) {
+            in.ignore((streamsize)len);
+            if ((size_t)in.gcount() != len) {
+                truncated = true;
+                return false;
+            }
+            ok = false;
+            return true;
+        }
+        string payload(len, '\0');
+        if (!in.read(&payload[0], len)) {
+            truncated = true;
+            return false;
+        }
+        v = fromBytes(payload);
+        return true;
+    };
+
+    // Reader: parses up to batchRecords records; invalid ones are kept as placeholders
+    auto read = [&](RecordBatch& batch) {
+        string line;
+        while (batch.valid.size() < batchRecords) {
+            BigInt v[2];
+            bool ok = true;
+            if (binary) {
+                bool more = readFrame(v[0], ok);
+                if (more && perRecord == 2 && !readFrame(v[1], ok)) truncated = true, more = false;
+                if (!more) break;
+            } else {
+                if (!getline(in, line)) break;
+                istringstream fields(line);
+                string tok[3];
+                size_t count = 0;
+                while (count < 3 && fields >> tok[count]) count++;
+                if (count == 0) continue;
+                ok = count == perRecord;
+                try {
+                    for (size_t f = 0; f < perRecord && ok; f++) v[f] = BigInt::fromString(tok[f]);
+                } catch (const invalid_argument&) {
+                    ok = false;
+                }
+            }
+            for (size_t f = 0; f < perRecord; f++) ok = ok && !v[f].neg && v[f] < kf.n;
+            batch.values.push_back(ok ? v[0] : BigInt());
+            if (verify) batch.sigs.push_back(ok ? v[1] : BigInt());
+            batch.valid.push_back(ok);
+        }
+        records += batch.valid.size();
+        return !batch.valid.empty();
+    };
+
+    // verify: one batch check over the well-formed pairs; pass[i] says whether pair i holds
+    auto checkBatch = [&](const RecordBatch& batch) {
+        vector<BigInt> msgs, sigs;
+        vector<size_t> at;
+        for (size_t i = 0; i < batch.valid.size(); i++) {
+            if (!batch.valid[i]) continue;
+            at.push_back(i);
+            msgs.push_back(batch.values[i]);
+            sigs.push_back(batch.sigs[i]);
+        }
+        vector<char> pass(batch.valid.size(), 1);
+        for (size_t j : batchVerify(msgs, sigs, kf.n, kf.e).failures) pass[at[j]] = 0;
+        return pass;
+    };
+
+    auto work = [&](RecordBatch& batch) {
+        vector<BigInt> res;
+        vector<char> pass;
+        if (verify) pass = checkBatch(batch);
+        else res = isPublic ? batchPower(batch.values, kf.e, kf.n) : key->privateOpBatch(batch.values);
+        for (size_t i = 0; i < batch.valid.size(); i++) {
+            if (!batch.valid[i]) errors++;
+            else if (verify && !pass[i]) rejected++;
+            if (binary) {
+                string bytes = !batch.valid[i] ? string() : verify ? string(1, (char)pass[i]) : toBytes(res[i]);
+                appendFrame(batch.out, bytes, batch.valid[i] ? bytes.size() : ERROR_FRAME);
+            } else {
+                string text = !batch.valid[i] ? "error" : verify ? (pass[i] ? "valid" : "invalid") : res[i].toString();
+                batch.out += text + '\n';
+            }
+        }
+    };
+
+    auto write = [](RecordBatch& batch) { cout.write(batch.out.data(), batch.out.size()); };
+
+    auto start = chrono::steady_clock::now();
+    orderedPipeline<RecordBatch>(pool, BATCHES_IN_FLIGHT * pool.size(), read, work, write);
+    cout.flush();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (truncated) cerr << "input ends inside a binary record; the partial record was dropped\n";
+    cerr << mode << ": " << records << " records, " << errors << " errors, ";
+    if (verify) cerr << rejected << " invalid signatures, ";
+    cerr << fixed << setprecision(2) << seconds
+         << " s (" << setprecision(0) << records / max(seconds, 1e-9) << " records/s, " << pool.size() << " threads, "
+         << simdLevelName(detectSimd()) << ")\n";
+    return 0;
+}
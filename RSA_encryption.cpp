@@ -3,75 +3,88 @@
 
     Purpose:
     - Small educational implementation of RSA key generation, encryption and decryption.
-    - NOT suitable for production: uses fixed-size `long long`, no padding, and simple input.
+    - NOT suitable for production: no padding and simple input.
+    - Numbers are BigInt (bignum.h), so p and q can be real 1024/2048-bit primes.
 
     Flow overview (main):
-    1) Read two distinct primes p and q.
-    2) Compute n = p * q and phi = (p-1)*(q-1).
+    1) Read two distinct primes p and q (or up to four primes for a multi-prime key),
+        or a single key size in bits to generate the primes (randomPrime, primes.h).
+        Typed primes are checked with the Baillie–PSW test.
+    2) Compute n = p * q * ... and phi = (p-1)*(q-1)*...
     3) Choose public exponent e such that gcd(e, phi) == 1.
     4) Compute private exponent d = e^{-1} mod phi.
-    5) Read message M (integer < n), compute ciphertext C = M^e mod n.
-    6) Decrypt with M = C^d mod n.
+    5) Read one or more messages M (integers < n), compute ciphertexts C = M^e mod n.
+        Several messages are encrypted together with batchPower (simd_modexp.h),
+        which runs 4-8 of them side by side in SIMD lanes.
+    6) Decrypt with M = C^d mod n, computed via CRT with one leg per prime (see rsa_key.h).
 
-    Helper functions:
+    Helper functions (shared, see bignum.h):
     - gcd: greatest common divisor (Euclid)
-    - power: fast modular exponentiation (square-and-multiply)
-    - modInverse: modular inverse using Extended Euclidean algorithm
+    - power: fast modular exponentiation (sliding window over Montgomery products)
+    - modInverse: modular inverse by Lehmer's extended GCD
 
     Notes:
-    - This code is for learning and testing with small numbers only.
+    - This code is for learning; generated primes come from a non-cryptographic RNG.
     - For real RSA use big-integer libraries (OpenSSL, GMP) and secure padding (OAEP).
 */
 
-#include <bits/stdc++.h>
-using namespace std;
+#include "primes.h"
+#include "rsa_key.h"
+#include "simd_modexp.h"
 
-// Compute greatest common divisor (Euclid's algorithm)
-long long gcd(long long a, long long b) {
-    if (b == 0) return a;
-    return gcd(b, a % b);
-}
-
-// Fast modular exponentiation: computes (a^b) % mod in O(log b) time
-long long power(long long a, long long b, long long mod) {
-    long long res = 1;
-    a %= mod;
-    while (b > 0) {
-        if (b & 1) res = (res * a) % mod;
-        a = (a * a) % mod;
-        b >>= 1;
+int main() {
+    // primes on one line: "p q" for classic RSA, "p q r [s]" for multi-prime RSA,
+    // or just the modulus size in bits ("2048") to generate p and q
+    vector<BigInt> primes;
+    string line;
+    cout << "Enter two distinct prime numbers (p and q, optionally more on the same line),\n"
+         << "or a key size in bits to generate them: ";
+    getline(cin >> ws, line);
+    istringstream in(line);
+    BigInt r;
+    while (in >> r) primes.push_back(r);
+
+    if (primes.size() == 1) {
+        int bits = (int)primes[0].low();
+        if (primes[0].limbs() > 1 || bits < 16 || bits > 16384) {
+            cout << "Key size must be between 16 and 16384 bits.\n";
+            return 0;
+        }
+        ThreadPool pool;
+        auto start = chrono::steady_clock::now();
+        primes.assign(1, randomPrime(bits / 2, pool));
+        do {
+            r = randomPrime(bits - bits / 2, pool);
+        } while (r == primes[0]);
+        primes.push_back(r);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Generated p = " << primes[0] << "\n          q = " << primes[1] << "\n";
+        cout << "(" << fixed << setprecision(1) << ms << " ms on " << pool.size() << " threads)\n";
     }
-    return res;
-}
-
-// Modular inverse using the Extended Euclidean Algorithm
-// Returns x such that (a * x) % m == 1 when gcd(a,m) == 1
-long long modInverse(long long a, long long m) {
-    long long m0 = m, y = 0, x = 1;
-    if (m == 1) return 0;
-
-    while (a > 1) {
-        long long q = a / m;
-        long long t = m;
-        m = a % m, a = t;
-        t = y;
-        y = x - q * y;
-        x = t;
+    if (primes.size() < 2 || primes.size() > 4) {
+        cout << "Need between 2 and 4 primes.\n";
+        return 0;
+    }
+    for (size_t i = 0; i < primes.size(); i++) {
+        if (!primes[i].isOdd() || !isProbablePrimeBPSW(primes[i])) {
+            cout << primes[i] << " is not an odd prime.\n";
+            return 0;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (primes[i] == primes[j]) {
+                cout << "The primes must be distinct.\n";
+                return 0;
+            }
+        }
     }
 
-    if (x < 0) x += m0;
-    return x;
-}
-
-int main() {
-    long long p, q;
-    cout << "Enter two distinct prime numbers (p and q): ";
-    cin >> p >> q;
+    BigInt n = 1, phi = 1;
+    for (const BigInt& prime : primes) {
+        n *= prime;
+        phi *= prime - 1;
+    }
 
-    long long n = p * q;
-    long long phi = (p - 1) * (q - 1);
-    
-    long long e = 3;
+    BigInt e = 3;
     while (e < phi && gcd(e, phi) != 1) {
         e += 2; // increment by 2 to keep e odd
     }
@@ -80,22 +93,28 @@ int main() {
         return 0;
     }
 
-    long long d = modInverse(e, phi);
+    // Private key: d = e^{-1} mod phi plus one CRT leg (d mod r-1, Garner coefficient) per prime
+    RSAPrivateKey key(primes, e);
+    BigInt d = key.d;
 
     cout << "\nPublic Key: (n = " << n << ", e = " << e << ")\n";
     cout << "Private Key: (d = " << d << ", n = " << n << ")\n";
 
-    long long M;
-    cout << "\nEnter message as a number (M < n): ";
-    cin >> M;
-
-    // Encryption
-    long long C = power(M, e, n);
-    cout << "Ciphertext: " << C << "\n";
-
-    // Decryption
-    long long decrypted = power(C, d, n);
-    cout << "Decrypted Message: " << decrypted << "\n";
+    vector<BigInt> messages;
+    cout << "\nEnter message(s) as numbers (M < n), separated by spaces: ";
+    getline(cin >> ws, line);
+    istringstream msgIn(line);
+    BigInt M;
+    while (msgIn >> M) messages.push_back(M);
+
+    // Encryption: all messages share e and n, so they go through the SIMD lanes together
+    vector<BigInt> C = batchPower(messages, e, n);
+    for (size_t i = 0; i < messages.size(); i++) {
+        // Decryption (CRT: one small exponentiation per prime)
+        BigInt decrypted = key.decrypt(C[i]);
+        cout << "Ciphertext: " << C[i] << "\n";
+        cout << "Decrypted Message: " << decrypted << "\n";
+    }
 
     return 0;
 }
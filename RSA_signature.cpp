@@ -7,60 +7,144 @@
         then shows a simple signature and verification using modular exponentiation.
 
     Important notes:
-    - This is NOT a secure implementation for real use: it uses fixed-size long long,
-        no padding or hashing of messages, and no secure randomness.
+    - This is NOT a secure implementation for real use: no padding, the
+        interactive demo signs the raw number M, and no secure randomness.
+    - Numbers are BigInt (bignum.h), so the same flow runs at 2048/4096-bit sizes.
     - For production use, use a proper crypto library (OpenSSL, libsodium) and
         follow standards (RSA-PSS, hashing, correct key sizes).
+
+    File mode (hash-then-sign, key file from `RSA_batch keygen`):
+        ./RSA_signature sign key.txt file... > sigs.txt
+        ./RSA_signature verify key.txt sigs.txt
+    - Each file is hashed with streaming SHA-256 (sha256.h: mmap, SHA-NI when
+        available) and the digest, as a number mod n, is signed: S = H(file)^d mod n.
+    - sigs.txt has one "<signature in hex>  <path>" line per file.
+    - Files are hashed in parallel on a ThreadPool; verify then checks every
+        signature with batchVerify (rsa_batch_verify.h: one by one for a short e,
+        a screen that lets a bad batch through below 2^-32 otherwise) and prints
+        OK / FAILED per file. A line of sigs.txt that does not parse is kept as a FAILED
+        (malformed) entry. The exit status is 1 when any entry fails.
 */
 
-#include <bits/stdc++.h>
-using namespace std;
+#include "rsa_key.h"
+#include "rsa_batch_verify.h"
+#include "sha256.h"
 
-// Compute greatest common divisor (Euclid's algorithm)
-long long gcd(long long a, long long b) {
-    if (b == 0) return a;
-    return gcd(b, a % b);
+// SHA-256 digest as a number below n (textbook hash-then-sign, no padding)
+BigInt digestToInteger(const Sha256Digest& d, const BigInt& n) {
+    BigInt x;
+    for (uint8_t b : d) x = (x << 8) + BigInt(b);
+    return x % n;
 }
 
-// fast modular exponentiation
-long long power(long long a, long long b, long long mod) {
-    long long res = 1;
-    a %= mod;
-    while (b > 0) {
-        if (b & 1) res = (res * a) % mod;
-        a = (a * a) % mod;
-        b >>= 1;
-    }
-    return res;
+void reportHashing(size_t files, u64 bytes, double seconds, unsigned threads) {
+    cerr << "hashed " << files << " files, " << fixed << setprecision(1) << bytes / 1e6 << " MB in " << setprecision(3)
+         << seconds << " s (" << setprecision(2) << bytes / max(seconds, 1e-9) / 1e9 << " GB/s, " << threads
+         << " threads, " << (cpuHasShaNi() ? "SHA-NI" : "portable SHA-256") << ")\n";
 }
 
-// modular inverse using Extended Euclid
-long long modInverse(long long a, long long m) {
-    long long m0 = m, y = 0, x = 1;
-    if (m == 1) return 0;
-
-    while (a > 1) {
-        long long q = a / m;
-        long long t = m;
-        m = a % m, a = t;
-        t = y;
-        y = x - q * y;
-        x = t;
+int fileMode(const string& mode, const string& keyPath, const vector<string>& args) {
+    RSAKeyFile kf;
+    if (!loadRSAKeyFile(keyPath, kf)) return 1;
+    ThreadPool pool;
+    vector<string> paths;
+    vector<BigInt> sigs;
+    vector<char> malformed;   // verify: lines that do not parse, kept and reported as FAILED
+    if (mode == "sign") {
+        if (kf.primes.size() < 2) {
+            cerr << "signing needs a key file with the primes\n";
+            return 1;
+        }
+        paths = args;
+    } else {
+        ifstream in(args.empty() ? "" : args[0]);
+        if (!in) {
+            cerr << "usage: RSA_signature verify key.txt sigs.txt\n";
+            return 1;
+        }
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            size_t gap = line.find("  ");
+            BigInt sig;
+            bool ok = gap != string::npos;
+            try {
+                if (ok) sig = BigInt::fromString(line.substr(0, gap));
+            } catch (const invalid_argument&) {
+                ok = false;
+            }
+            if (!ok) cerr << "malformed line: " << line << "\n";
+            sigs.push_back(sig);
+            paths.push_back(ok ? line.substr(gap + 2) : line);
+            malformed.push_back(!ok);
+        }
+    }
+    malformed.resize(paths.size(), 0);
+
+    auto start = chrono::steady_clock::now();
+    vector<Sha256Digest> digests;
+    vector<char> readable;
+    vector<string> toHash = paths;
+    for (size_t i = 0; i < paths.size(); i++)
+        if (malformed[i]) toHash[i].clear();   // not a file name: not hashed
+    u64 bytes = sha256Files(toHash, pool, digests, readable);
+    reportHashing(paths.size(), bytes, chrono::duration<double>(chrono::steady_clock::now() - start).count(), pool.size());
+
+    vector<BigInt> hashes;
+    vector<size_t> at;   // index into paths of every readable file
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (malformed[i]) continue;
+        if (!readable[i]) {
+            cerr << paths[i] << ": cannot read\n";
+            continue;
+        }
+        at.push_back(i);
+        hashes.push_back(digestToInteger(digests[i], kf.n));
+    }
+
+    if (mode == "sign") {
+        RSAPrivateKey key(kf.primes, kf.e);
+        vector<BigInt> out = key.privateOpBatch(hashes);
+        for (size_t j = 0; j < at.size(); j++) cout << out[j].toHex() << "  " << paths[at[j]] << "\n";
+        return at.size() == paths.size() ? 0 : 1;
     }
 
-    if (x < 0) x += m0;
-    return x;
+    vector<BigInt> given;
+    for (size_t i : at) given.push_back(sigs[i]);
+    BatchVerifyResult res = batchVerify(hashes, given, kf.n, kf.e);
+    vector<char> pass(paths.size(), 0);
+    for (size_t i : at) pass[i] = 1;
+    for (size_t j : res.failures) pass[at[j]] = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        cout << paths[i] << ": "
+             << (malformed[i] ? "FAILED (malformed)" : !readable[i] ? "FAILED (cannot read)" : pass[i] ? "OK" : "FAILED") << "\n";
+        failed += !pass[i];
+    }
+    cerr << failed << " of " << paths.size() << " signatures failed (" << res.screens << " batch tests)\n";
+    return failed ? 1 : 0;
 }
 
-int main() {
-    long long p, q;
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        string mode = argv[1];
+        if ((mode != "sign" && mode != "verify") || argc < 4) {
+            cerr << "usage: RSA_signature                          (interactive demo)\n"
+                    "       RSA_signature sign key.txt file...     (hash-then-sign, signatures to stdout)\n"
+                    "       RSA_signature verify key.txt sigs.txt\n";
+            return 1;
+        }
+        return fileMode(mode, argv[2], vector<string>(argv + 3, argv + argc));
+    }
+
+    BigInt p, q;
     cout << "Enter two distinct prime numbers (p and q): ";
     cin >> p >> q;
 
-    long long n = p * q;
-    long long phi = (p - 1) * (q - 1);
+    BigInt n = p * q;
+    BigInt phi = (p - 1) * (q - 1);
 
-    long long e = 3;
+    BigInt e = 3;
     while (e < phi && gcd(e, phi) != 1) {
         e += 2; // increment by 2 to keep e odd
     }
@@ -69,21 +153,23 @@ int main() {
         return 0;
     }
 
-    long long d = modInverse(e, phi);
+    // Private key: d = e^{-1} mod phi plus the CRT values dP, dQ, qInv
+    RSAPrivateKey key(p, q, e);
+    BigInt d = key.d;
 
     cout << "\nPublic Key: (n = " << n << ", e = " << e << ")\n";
     cout << "Private Key: (d = " << d << ", n = " << n << ")\n";
 
-    long long M;
+    BigInt M;
     cout << "\nEnter message as a number (M < n): ";
     cin >> M;
 
-    // ---- Signature Generation ----
-    long long S = power(M, d, n);
+    // ---- Signature Generation (S = M^d mod n via CRT) ----
+    BigInt S = key.sign(M);
     cout << "\nSignature (S): " << S << "\n";
 
     // ---- Signature Verification ----
-    long long V = power(S, e, n);
+    BigInt V = power(S, e, n);
     cout << "\nVerification:\n";
     cout << "Recovered message = " << V << "\n";
 
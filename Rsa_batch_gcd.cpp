@@ -0,0 +1,245 @@
+/*
+    Rsa_batch_gcd.cpp
+
+    Purpose:
+    - Audit a corpus of RSA public moduli for shared prime factors. Keys generated
+        with a weak random number generator sometimes reuse a prime; then
+        gcd(n_i, n_j) = p factors both keys instantly, no factoring needed.
+    - Checking every pair costs N^2 / 2 gcds (5 * 10^11 for a million keys).
+        Bernstein's batch GCD finds, for every key at once,
+        g_i = gcd(n_i, product of all the other moduli) in quasi-linear time.
+
+    Flow (main):
+    1) Read the moduli from a file: one per line, decimal or 0x hex; only the
+        first token of a line is used (so "n e" lines work), blank lines and
+        lines starting with '#' are skipped.
+    2) Product tree: level 0 holds the moduli, every level above holds the
+        pairwise products of the one below, up to P = n_0 * n_1 * ... * n_{N-1}.
+    3) Remainder tree: going back down, every node N needs P mod N^2, so a leaf
+        ends with R_i = P mod n_i^2. The tree is "scaled" (Bernstein 2004): each
+        node keeps the fixed-point fraction y = frac(P / N^2) instead, which a
+        child gets from its parent with two multiplications by its sibling and
+        no division; at a leaf R_i = round(y_i * n_i^2). Guard bits (64 plus two
+        per level) absorb the truncation error that builds up on the way down.
+    4) g_i = gcd(R_i / n_i, n_i): R_i / n_i is (P / n_i) mod n_i, the product of
+        all other moduli reduced mod n_i. g_i > 1 means key i shares a prime.
+    5) Keys whose g_i == n_i (duplicate modulus, or both primes shared with
+        different keys) are split afterwards by pairwise gcds among the flagged keys.
+
+    Scaling:
+    - Every level of both trees is computed in parallel on a ThreadPool.
+    - Cost is O(M(total bits) * log N): the big products use the NTT multiplier
+        from bignum.h, and the only long division is the one reciprocal 1 / P at the root.
+        Only the top levels run on few cores; everything below them is spread out.
+    - Memory: finished product-tree levels are spilled to temporary files and
+        read back one at a time on the way down, so besides the input only about
+        three levels' worth of numbers are resident at once. Leaves are handled
+        in blocks and their findings are printed as they are found.
+
+    Usage:
+    - ./Rsa_batch_gcd moduli.txt [threads]   (asks for the file when no argument is given)
+*/
+
+#include "bignum.h"
+#include "thread_pool.h"
+
+const int LEAF_BLOCK = 4096; // leaves processed (and reported) per block
+
+double msSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// One product-tree level on disk: per number, its limb count followed by the limbs
+FILE* spillLevel(const vector<BigInt>& level) {
+    FILE* f = tmpfile();
+    if (!f) throw runtime_error("cannot create a temporary file for the product tree");
+    for (const BigInt& x : level) {
+        u64 len = x.mag.size();
+        fwrite(&len, sizeof len, 1, f);
+        fwrite(x.mag.data(), sizeof(u64), len, f);
+    }
+    return f;
+}
+
+vector<BigInt> loadLevel(FILE* f, size_t count) {
+    rewind(f);
+    vector<BigInt> level(count);
+    for (BigInt& x : level) {
+        u64 len = 0;
+        if (fread(&len, sizeof len, 1, f) != 1) throw runtime_error("product tree spill file is truncated");
+        x.mag.resize(len);
+        if (fread(x.mag.data(), sizeof(u64), len, f) != len) throw runtime_error("product tree spill file is truncated");
+    }
+    fclose(f);
+    return level;
+}
+
+// frac(P / N^2) for a node N of the product tree, as y / 2^prec (0 <= y < 2^prec)
+struct Fraction {
+    BigInt y;
+    int prec = 0;
+};
+
+// (x mod 2^from) rescaled to `to` fractional bits: keeps the fractional part of x / 2^from
+BigInt fractionBits(const BigInt& x, int from, int to) {
+    BigInt low = x;
+    int limbs = (from + 63) / 64;
+    if ((int)low.mag.size() >= limbs) {
+        low.mag.resize(limbs);
+        if (from % 64) low.mag.back() &= ~0ULL >> (64 - from % 64);
+    }
+    low.trim();
+    return to <= from ? low >> (from - to) : low << (to - from);
+}
+
+// Child i of a level from its parent's fraction: with N_parent = N_i * N_s (s the sibling),
+// P / N_i^2 = (P / N_parent^2) * N_s^2, so y_i = frac(y_parent * N_s * N_s). Two products
+// and two truncations replace the division R_parent mod N_i^2 of the plain remainder tree.
+Fraction childFraction(const Fraction& parent, const vector<BigInt>& nodes, long long i, int guard) {
+    long long s = i ^ 1;
+    if (s >= (long long)nodes.size()) return parent; // odd node carried up unchanged
+    const BigInt& sib = nodes[s];
+    int bits = 2 * nodes[i].bitLength() + guard;
+    Fraction child;
+    int mid = bits + sib.bitLength();
+    BigInt t = fractionBits(parent.y * sib, parent.prec, mid);
+    child.y = fractionBits(t * sib, mid, bits);
+    child.prec = bits;
+    return child;
+}
+
+// Moduli from a text file; malformed lines are reported and skipped
+vector<BigInt> readModuli(const string& path, vector<int>& lineOf) {
+    ifstream in(path);
+    if (!in) throw runtime_error("cannot open " + path);
+    vector<BigInt> moduli;
+    string line;
+    for (int lineNo = 1; getline(in, line); lineNo++) {
+        istringstream ss(line);
+        string tok;
+        if (!(ss >> tok) || tok[0] == '#') continue;
+        try {
+            BigInt n = BigInt::fromString(tok);
+            if (n < BigInt(2)) throw invalid_argument("modulus below 2");
+            moduli.push_back(n);
+            lineOf.push_back(lineNo);
+        } catch (const exception& ex) {
+            cerr << "line " << lineNo << ": skipped (" << ex.what() << ")\n";
+        }
+    }
+    return moduli;
+}
+
+int main(int argc, char** argv) {
+    string path;
+    if (argc > 1) {
+        path = argv[1];
+    } else {
+        cout << "Enter the path of the moduli file: ";
+        cin >> path;
+    }
+    ThreadPool pool(argc > 2 ? (unsigned)atoi(argv[2]) : 0);
+
+    vector<int> lineOf;
+    vector<BigInt> moduli;
+    try {
+        moduli = readModuli(path, lineOf);
+    } catch (const exception& ex) {
+        cout << ex.what() << "\n";
+        return 0;
+    }
+    size_t N = moduli.size();
+    cout << "Loaded " << N << " moduli from " << path << "\n";
+    if (N < 2) {
+        cout << "Need at least two moduli.\n";
+        return 0;
+    }
+
+    // 2) product tree, bottom-up; every finished level goes to disk
+    auto start = chrono::steady_clock::now();
+    auto pairUp = [&](const vector<BigInt>& below) {
+        vector<BigInt> up((below.size() + 1) / 2);
+        parallelFor(pool, (long long)up.size(), [&](long long i) {
+            up[i] = 2 * i + 1 < (long long)below.size() ? below[2 * i] * below[2 * i + 1] : below[2 * i];
+        });
+        return up;
+    };
+    vector<FILE*> spilled{nullptr}; // level 0 stays in `moduli` and is read from there, never copied
+    vector<size_t> counts{N};
+    vector<BigInt> level = pairUp(moduli);
+    while (level.size() > 1) {
+        spilled.push_back(spillLevel(level));
+        counts.push_back(level.size());
+        level = pairUp(level);
+    }
+    double productMs = msSince(start);
+    cout << "Product tree: " << spilled.size() + 1 << " levels, root has " << level[0].bitLength() << " bits\n";
+
+    // 3) scaled remainder tree, top-down, stopping one level above the leaves
+    start = chrono::steady_clock::now();
+    int guard = 64 + 2 * (int)spilled.size();
+    vector<Fraction> rem(1);
+    // frac(P / P^2) = 1 / P: floor(B^(2k+e) / P) straight from the Newton reciprocal of P * B^e
+    int extra = guard / 64 + 1, k = level[0].limbs();
+    rem[0].y = BigInt::reciprocal(level[0] << (64 * extra));
+    rem[0].prec = 64 * (2 * k + extra);
+    for (int l = (int)spilled.size() - 1; l >= 1; l--) {
+        vector<BigInt> nodes = loadLevel(spilled[l], counts[l]);
+        vector<Fraction> down(nodes.size());
+        parallelFor(pool, (long long)nodes.size(), [&](long long i) {
+            down[i] = childFraction(rem[i / 2], nodes, i, guard);
+        });
+        rem = move(down);
+    }
+    double remainderMs = msSince(start);
+
+    // 4) leaves in blocks: R_i = P mod n_i^2 = round(y_i * n_i^2), g_i = gcd(R_i / n_i, n_i)
+    start = chrono::steady_clock::now();
+    cout << "\nKeys sharing a prime (line numbers refer to the input file):\n";
+    vector<BigInt> g(N);
+    vector<size_t> whole; // g_i == n_i, resolved below
+    size_t weak = 0;
+    for (size_t base = 0; base < N; base += LEAF_BLOCK) {
+        size_t end = min(N, base + LEAF_BLOCK);
+        parallelFor(pool, (long long)(end - base), [&](long long j) {
+            size_t i = base + j;
+            const BigInt& n = moduli[i];
+            Fraction leaf = childFraction(rem[i / 2], moduli, i, guard);
+            BigInt n2 = n * n;
+            BigInt R = (leaf.y * n2 + (BigInt(1) << (leaf.prec - 1))) >> leaf.prec; // round(y * n^2)
+            if (R == n2) R = 0;
+            g[i] = gcd(R / n, n);
+        });
+        for (size_t i = base; i < end; i++) {
+            if (g[i] == BigInt(1)) continue;
+            weak++;
+            if (g[i] == moduli[i]) {
+                whole.push_back(i);
+                continue;
+            }
+            cout << "  line " << lineOf[i] << ": p = " << g[i] << ", q = " << moduli[i] / g[i] << "\n";
+        }
+    }
+
+    // 5) g_i == n_i: try the other flagged keys one by one
+    for (size_t i : whole) {
+        BigInt split;
+        for (size_t j = 0; j < N && split.isZero(); j++) {
+            if (j == i || g[j] == BigInt(1)) continue;
+            BigInt d = gcd(moduli[i], moduli[j]);
+            if (d != BigInt(1) && d != moduli[i]) split = d;
+        }
+        if (split.isZero())
+            cout << "  line " << lineOf[i] << ": modulus is duplicated elsewhere in the corpus (no split)\n";
+        else
+            cout << "  line " << lineOf[i] << ": p = " << split << ", q = " << moduli[i] / split << "\n";
+    }
+    double leafMs = msSince(start);
+
+    if (weak == 0) cout << "  none\n";
+    cout << fixed << setprecision(2);
+    cout << "\n" << weak << " of " << N << " keys share a factor with another key.\n";
+    cout << "Time (" << pool.size() << " threads): product tree " << productMs << " ms, remainder tree "
+         << remainderMs << " ms, leaf gcds " << leafMs << " ms\n";
+    return 0;
+}
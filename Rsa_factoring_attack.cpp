@@ -0,0 +1,78 @@
+/*
+    Rsa_factoring_attack.cpp
+
+    Purpose:
+    - Educational demo of the classic key-recovery attack on small RSA moduli:
+        factor n, rebuild phi, and recompute the private exponent d from the
+        public key alone.
+    - Complements Rsa_signature_plaintext_attack.cpp, which only shows that many
+        exponents work once d is known.
+
+    Flow (main):
+    1) Read the public key (n, e).
+    2) Factor n with the engine in factor.h:
+        trial division (mod-30 wheel) -> Pollard–Brent rho -> ECM,
+        each stage spread over a thread pool.
+    3) phi = product of p^(k-1) * (p-1) over the prime powers p^k dividing n.
+    4) d = modInverse(e, phi), then check it by encrypting and decrypting a test value.
+    5) Print how long each stage took.
+
+    Notes:
+    - Practical up to roughly 128-bit moduli (two ~64-bit primes); this is exactly
+        why real RSA keys use primes of 1024 bits and more.
+*/
+
+#include "factor.h"
+
+int main() {
+    BigInt n, e;
+    cout << "Enter the public key (n and e): ";
+    cin >> n >> e;
+    if (n < BigInt(2)) {
+        cout << "n must be at least 2.\n";
+        return 0;
+    }
+
+    ThreadPool pool;
+    FactorStats stats;
+    auto start = chrono::steady_clock::now();
+    vector<BigInt> factors = factorize(n, pool, &stats);
+    double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << "\nFactors of n:";
+    for (const BigInt& f : factors) cout << " " << f;
+    cout << "\n";
+    if (!stats.unfactored.empty()) {
+        cout << "Could not split:";
+        for (const BigInt& f : stats.unfactored) cout << " " << f;
+        cout << "\nKey not recovered.\n";
+        return 0;
+    }
+
+    // phi(n) from the prime-power decomposition
+    BigInt phi = 1;
+    for (size_t i = 0; i < factors.size(); i++) {
+        bool repeated = i > 0 && factors[i] == factors[i - 1];
+        phi *= repeated ? factors[i] : factors[i] - 1;
+    }
+
+    if (gcd(e, phi) != BigInt(1)) {
+        cout << "e is not invertible mod phi = " << phi << "; not a valid RSA key.\n";
+        return 0;
+    }
+    BigInt d = modInverse(e, phi);
+    cout << "phi(n) = " << phi << "\n";
+    cout << "Recovered private exponent d = " << d << "\n";
+
+    BigInt M = BigInt(42) % n;
+    BigInt C = power(M, e, n);
+    if (power(C, d, n) == M)
+        cout << "Check: decrypting a test ciphertext with d works.\n";
+    else
+        cout << "Check FAILED: d does not decrypt.\n";
+
+    cout << fixed << setprecision(2);
+    cout << "\nTime (" << pool.size() << " threads): trial division " << stats.trialMs << " ms, rho "
+         << stats.rhoMs << " ms, ECM " << stats.ecmMs << " ms, total " << totalMs << " ms\n";
+    return 0;
+}
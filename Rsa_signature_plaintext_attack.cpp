@@ -8,47 +8,103 @@
     - Demonstrates encryption/decryption with both exponents and (optionally)
         brute-forces small exponents that correctly decrypt the ciphertext.
 
+    Finding every working exponent:
+    - Closed form: en^i == m exactly when i == b1 (mod ord), where ord is the
+        multiplicative order of the ciphertext en. ord divides lambda(n) =
+        lcm(p-1, q-1), so it is found from the prime factors of p-1 and q-1 with a
+        few modexps, and every valid d is listed as b1 mod ord + k*ord without scanning.
+    - Brute force (kept for comparison): instead of a fresh power(en, i, n) per i,
+        each range chunk starts with one modexp and then steps by one Montgomery
+        multiplication by en. Chunks are handed out in increasing order to a thread
+        pool; once the first `limit` hits are known in order, later chunks stop.
+
     Notes:
     - This is for learning only. It uses `long long` and is limited to small primes.
-    - Brute-forcing exponents is infeasible for real RSA-sized moduli.
+    - Brute-forcing exponents is infeasible for real RSA-sized moduli; the scan is
+        capped at SCAN_LIMIT exponents.
     - The code does not perform primality checks on p and q; assume the user inputs primes.
 */
 
-#include<bits/stdc++.h>
-using namespace std;
+#include "modarith.h"
+#include "thread_pool.h"
 
 #define ll long long
 
-ll gcd(ll a, ll b){
-    if ( b == 0 ) return a;
-    return gcd(b, a%b);
+const ll SCAN_LIMIT = 1LL << 32;     // largest exponent the brute-force scan will try
+const ll SCAN_CHUNK = 1 << 16;       // exponents per task; each chunk starts with one modexp
+
+// distinct prime factors of x (trial division)
+vector<ll> primeFactors(ll x){
+    vector<ll> f;
+    for (ll i = 2; i * i <= x; i++){
+        if (x % i == 0){
+            f.push_back(i);
+            while (x % i == 0) x /= i;
+        }
+    }
+    if (x > 1) f.push_back(x);
+    return f;
 }
 
-ll power(ll a, ll b, ll m){
-    ll result = 1;
-    a = a%m;
-    while(b>0){
-        if (b&1) result = (result * a)%m;
-        a = ( a*a ) % m;
-        b >>= 1;
+// multiplicative order of a mod n, given a multiple `lambda` of it and lambda's prime factors
+ll multiplicativeOrder(ll a, ll n, ll lambda, const vector<ll>& factors){
+    ll ord = lambda;
+    for (ll f : factors){
+        while (ord % f == 0 && power(a, ord / f, n) == 1) ord /= f;
     }
-    return result;
+    return ord;
 }
 
-ll modInverse(ll a, ll m){
-    ll m0=m, x=1, y=0;
-    if(m==1) return 0;
-
-    while(a>1){   
-        ll q = a / m;
-        ll t = m;
-        m = a % m, a = t;
-        t = y;
-        y = x - q*y;
-        x = t;
+// All i in [lo, hi) with en^i == m (mod n), smallest first, stopping after `limit` hits.
+// Steps incrementally inside chunks, chunks run in order on the pool with early termination.
+vector<ll> searchExponents(ll en, ll m, ll n, ll lo, ll hi, size_t limit, ThreadPool& pool){
+    ll chunks = (hi - lo + SCAN_CHUNK - 1) / SCAN_CHUNK;
+    vector<vector<ll>> hits(max(chunks, 0LL));
+    vector<char> done(max(chunks, 0LL), 0);
+    atomic<ll> stopChunk(LLONG_MAX);   // chunks after this one cannot change the answer
+    mutex mtx;
+    ll prefix = 0;                     // chunks [0, prefix) are finished
+    size_t prefixHits = 0;
+
+    bool odd = n & 1;
+    Montgomery mont(odd ? n : 1);      // only used for odd n
+    ll target = m % n;
+    u64 targetMont = odd ? mont.toMont(target) : 0;
+    u64 stepMont = odd ? mont.toMont(en % n) : 0;
+
+    parallelFor(pool, chunks, [&](ll c){
+        if (c > stopChunk) return;
+        ll start = lo + c * SCAN_CHUNK, end = min(hi, start + SCAN_CHUNK);
+        vector<ll> local;
+        ll cur = power(en, start, n);
+        u64 curMont = odd ? mont.toMont(cur) : 0;
+        for (ll i = start; i < end; i++){
+            if ((i & 4095) == 0 && c > stopChunk) return;
+            if (odd ? curMont == targetMont : cur == target){
+                local.push_back(i);
+                if (local.size() >= limit) break;
+            }
+            if (odd) curMont = mont.mul(curMont, stepMont);
+            else cur = mulMod(cur, en % n, n);
+        }
+
+        lock_guard<mutex> lock(mtx);
+        hits[c] = local;
+        done[c] = 1;
+        while (prefix < chunks && done[prefix] && prefixHits < limit){
+            prefixHits += hits[prefix].size();
+            if (prefixHits >= limit) stopChunk = prefix;
+            prefix++;
+        }
+    });
+
+    vector<ll> found;
+    for (ll c = 0; c < chunks && found.size() < limit; c++){
+        for (ll i : hits[c]){
+            if (found.size() < limit) found.push_back(i);
+        }
     }
-    if (x < 0) x = x+m0;
-    return x;
+    return found;
 }
 
 int main(){
@@ -87,15 +143,27 @@ int main(){
     cout << "Decrypted with b1: " << dec1 << "\n";
     cout << "Decrypted with b2: " << dec2 << "\n";
 
-    // brute-force search to find up to two exponents d that decrypt to the message
-    vector<ll> found;
-    for (ll i = 3; i < n && found.size() < 2; ++i) {
-        ll de = power(en, i, n);
-        if (de == m) {
-            found.push_back(i);
+    // closed form: the valid exponents are exactly b1 (mod ord(en))
+    if (gcd(en, n) == 1){
+        ll lambda = (p-1) / gcd(p-1, q-1) * (q-1);
+        vector<ll> factors = primeFactors(p-1);
+        for (ll f : primeFactors(q-1)){
+            if (find(factors.begin(), factors.end(), f) == factors.end()) factors.push_back(f);
         }
+        ll ord = multiplicativeOrder(en, n, lambda, factors);
+        ll first = b1 % ord;
+        while (first < 3) first += ord;
+        cout << "Order of the ciphertext: ord = " << ord << " (divides lambda(n) = " << lambda << ")\n";
+        cout << "Every valid d: d = " << first << " + k*" << ord << "  (k >= 0)\n";
+        cout << "Smallest values of d: " << first << ", " << first + ord << "\n";
+    } else {
+        cout << "Ciphertext shares a factor with n; no closed form, scanning only.\n";
     }
 
+    // brute-force search to find up to two exponents d that decrypt to the message
+    ThreadPool pool;
+    vector<ll> found = searchExponents(en, m, n, 3, min(n, SCAN_LIMIT), 2, pool);
+
     if (!found.empty()) {
         cout << "Found d values via brute-force:\n";
         for(int i=0;i<found.size();i++){
@@ -0,0 +1,1224 @@
+/*
+    bignum.h — arbitrary-precision integers for the RSA demos
+
+    Purpose:
+    - Lets the RSA programs run the same gcd / power / modInverse flow on real
+        key sizes (2048- and 4096-bit moduli) instead of `long long`.
+    - Header-only, built on 64-bit limbs with 128-bit intermediate products.
+
+    Representation:
+    - BigInt = sign + magnitude; `mag` holds little-endian 64-bit limbs with
+        no leading zero limbs (zero is the empty vector).
+    - Division truncates toward zero and % takes the sign of the dividend,
+        exactly like `long long`, so the textbook code keeps working unchanged.
+
+    Algorithms:
+    - Multiplication: schoolbook below karatsubaThreshold limbs, Karatsuba above,
+        and a number-theoretic transform (NTT) once both factors reach
+        nttThreshold limbs. The thresholds were tuned with Bignum_benchmark.cpp.
+    - Division: Knuth's Algorithm D (TAOCP vol. 2, 4.3.1); divisors of
+        newtonThreshold limbs and more use a Newton reciprocal plus Barrett
+        reduction, so huge divisions cost a few multiplications instead of
+        quadratic time (needed by the product / remainder trees of batch GCD).
+    - Modular exponentiation: Montgomery form (BigMontgomery) for odd moduli;
+        the product is computed with the multiplier above and then reduced by
+        word-by-word REDC, so no long division happens in the exponent loop.
+        The exponent is scanned with the sliding-window engine from modarith.h;
+        powerConstTime uses its fixed-window variant.
+
+    Notes:
+    - Educational code: powerConstTime fixes the operation sequence and table
+        access pattern, but the limb kernels are not audited for constant time.
+*/
+
+#pragma once
+
+#include "modarith.h"
+
+// Operand size (in limbs) below which schoolbook multiplication beats Karatsuba.
+// A variable rather than a constant so Bignum_benchmark.cpp can sweep it.
+inline int karatsubaThreshold = 32;
+
+// karatsubaThreshold as the kernels read it: below 4 limbs the (a0+a1) half has as many
+// limbs as the operand, so Karatsuba would recurse forever and overrun its scratch.
+inline int karatsubaCutoff() {
+    return max(karatsubaThreshold, 4);
+}
+
+// ---- Raw limb kernels (little-endian arrays) ----
+
+// r[0..na+nb) = a * b (schoolbook); r must not overlap a or b
+inline void mulSchoolbook(u64* r, const u64* a, int na, const u64* b, int nb) {
+    fill(r, r + na + nb, 0);
+    for (int i = 0; i < na; i++) {
+        u64 carry = 0;
+        u64 ai = a[i];
+        for (int j = 0; j < nb; j++) {
+            u128 t = (u128)ai * b[j] + r[i + j] + carry;
+            r[i + j] = (u64)t;
+            carry = (u64)(t >> 64);
+        }
+        r[i + nb] = carry;
+    }
+}
+
+// r[0..2n) = a^2 (schoolbook): off-diagonal products once, doubled, plus squares
+inline void sqrSchoolbook(u64* r, const u64* a, int n) {
+    fill(r, r + 2 * n, 0);
+    for (int i = 0; i < n; i++) {
+        u64 carry = 0;
+        for (int j = i + 1; j < n; j++) {
+            u128 t = (u128)a[i] * a[j] + r[i + j] + carry;
+            r[i + j] = (u64)t;
+            carry = (u64)(t >> 64);
+        }
+        r[i + n] = carry;
+    }
+    u64 top = 0;
+    for (int i = 0; i < 2 * n; i++) {
+        u64 v = r[i];
+        r[i] = (v << 1) | top;
+        top = v >> 63;
+    }
+    u64 carry = 0;
+    for (int i = 0; i < n; i++) {
+        u128 sq = (u128)a[i] * a[i];
+        u128 t = (u128)r[2 * i] + (u64)sq + carry;
+        r[2 * i] = (u64)t;
+        t = (u128)r[2 * i + 1] + (u64)(sq >> 64) + (u64)(t >> 64);
+        r[2 * i + 1] = (u64)t;
+        carry = (u64)(t >> 64);
+    }
+}
+
+// r[0..n) += a[0..n), returns carry out
+inline u64 addLimbs(u64* r, const u64* a, int n) {
+    u64 carry = 0;
+    for (int i = 0; i < n; i++) {
+        u128 t = (u128)r[i] + a[i] + carry;
+        r[i] = (u64)t;
+        carry = (u64)(t >> 64);
+    }
+    return carry;
+}
+
+// r[0..n) -= a[0..n), returns borrow out
+inline u64 subLimbs(u64* r, const u64* a, int n) {
+    u64 borrow = 0;
+    for (int i = 0; i < n; i++) {
+        u128 t = (u128)r[i] - a[i] - borrow;
+        r[i] = (u64)t;
+        borrow = (u64)(t >> 64) ? 1 : 0;
+    }
+    return borrow;
+}
+
+// Propagate a carry into r[0..n), returns carry out
+inline u64 addCarry(u64* r, int n, u64 carry) {
+    for (int i = 0; i < n && carry; i++) {
+        r[i] += carry;
+        carry = r[i] < carry;
+    }
+    return carry;
+}
+
+// Scratch limbs needed by mulKaratsuba / sqrKaratsuba for operands of n limbs
+inline int karatsubaScratch(int n) {
+    return 6 * n + 64;
+}
+
+// r[0..2n) = a * b for equal-length operands; scratch holds karatsubaScratch(n) limbs
+//   a = a1*B^h + a0, b = b1*B^h + b0
+//   a*b = z2*B^2h + (z1 - z2 - z0)*B^h + z0, z1 = (a0+a1)(b0+b1)
+inline void mulKaratsuba(u64* r, const u64* a, const u64* b, int n, u64* scratch) {
+    if (n < karatsubaCutoff()) {
+        mulSchoolbook(r, a, n, b, n);
+        return;
+    }
+    int h = n / 2, hh = n - h;
+    mulKaratsuba(r, a, b, h, scratch);                    // z0 -> r[0..2h)
+    mulKaratsuba(r + 2 * h, a + h, b + h, hh, scratch);   // z2 -> r[2h..2n)
+
+    u64* sa = scratch;
+    u64* sb = sa + hh + 1;
+    u64* z1 = sb + hh + 1;
+    u64* rest = z1 + 2 * (hh + 1);
+    copy(a + h, a + n, sa);
+    sa[hh] = 0;
+    if (addLimbs(sa, a, h)) addCarry(sa + h, hh - h + 1, 1);
+    copy(b + h, b + n, sb);
+    sb[hh] = 0;
+    if (addLimbs(sb, b, h)) addCarry(sb + h, hh - h + 1, 1);
+    mulKaratsuba(z1, sa, sb, hh + 1, rest);
+
+    // z1 -= z0 + z2 (never goes negative)
+    int zn = 2 * (hh + 1);
+    u64 borrow = subLimbs(z1, r, 2 * h);
+    for (int i = 2 * h; i < zn && borrow; i++) borrow = (z1[i]-- == 0);
+    borrow = subLimbs(z1, r + 2 * h, 2 * hh);
+    for (int i = 2 * hh; i < zn && borrow; i++) borrow = (z1[i]-- == 0);
+
+    // r += z1 * B^h
+    int len = min(zn, 2 * n - h);
+    u64 carry = addLimbs(r + h, z1, len);
+    addCarry(r + h + len, 2 * n - h - len, carry);
+}
+
+// r[0..2n) = a^2, same layout as mulKaratsuba with z1 = (a0+a1)^2
+inline void sqrKaratsuba(u64* r, const u64* a, int n, u64* scratch) {
+    if (n < karatsubaCutoff()) {
+        sqrSchoolbook(r, a, n);
+        return;
+    }
+    int h = n / 2, hh = n - h;
+    sqrKaratsuba(r, a, h, scratch);
+    sqrKaratsuba(r + 2 * h, a + h, hh, scratch);
+
+    u64* sa = scratch;
+    u64* z1 = sa + hh + 1;
+    u64* rest = z1 + 2 * (hh + 1);
+    copy(a + h, a + n, sa);
+    sa[hh] = 0;
+    if (addLimbs(sa, a, h)) addCarry(sa + h, hh - h + 1, 1);
+    sqrKaratsuba(z1, sa, hh + 1, rest);
+
+    int zn = 2 * (hh + 1);
+    u64 borrow = subLimbs(z1, r, 2 * h);
+    for (int i = 2 * h; i < zn && borrow; i++) borrow = (z1[i]-- == 0);
+    borrow = subLimbs(z1, r + 2 * h, 2 * hh);
+    for (int i = 2 * hh; i < zn && borrow; i++) borrow = (z1[i]-- == 0);
+
+    int len = min(zn, 2 * n - h);
+    u64 carry = addLimbs(r + h, z1, len);
+    addCarry(r + h + len, 2 * n - h - len, carry);
+}
+
+// ---- NTT multiplication (very large operands) ----
+//
+// Number-theoretic transform modulo the prime P = 2^64 - 2^32 + 1. Operands are
+// split into 16-bit digits, so every convolution coefficient is below
+// (digits) * 2^32 < P for products of up to 2^31 digits, and a single prime is
+// enough (no CRT). Reduction uses 2^64 = 2^32 - 1 and 2^96 = -1 (mod P).
+
+const u64 NTT_P = 0xffffffff00000001ULL;
+const u64 NTT_EPS = 0xffffffffULL; // 2^64 mod P
+
+// Branch-free: the carries of a transform are data-dependent coin flips, so masks beat jumps
+inline u64 nttReduce(u128 x) {
+    u64 lo = (u64)x, hi = (u64)(x >> 64);
+    u64 hiHi = hi >> 32, hiLo = hi & NTT_EPS;
+    u64 t0, t2;
+    bool borrow = __builtin_sub_overflow(lo, hiHi, &t0);
+    t0 -= NTT_EPS & ((u64)0 - borrow);
+    bool carry = __builtin_add_overflow(t0, hiLo * NTT_EPS, &t2);
+    t2 += NTT_EPS & ((u64)0 - carry);
+    return t2 - (NTT_P & ((u64)0 - (t2 >= NTT_P)));
+}
+
+inline u64 nttMul(u64 a, u64 b) { return nttReduce((u128)a * b); }
+inline u64 nttAdd(u64 a, u64 b) {
+    u64 s;
+    bool carry = __builtin_add_overflow(a, b, &s);
+    return s - (NTT_P & ((u64)0 - (carry | (s >= NTT_P))));
+}
+inline u64 nttSub(u64 a, u64 b) {
+    u64 d;
+    bool borrow = __builtin_sub_overflow(a, b, &d);
+    return d + (NTT_P & ((u64)0 - borrow));
+}
+
+inline u64 nttPow(u64 a, u64 e) {
+    u64 r = 1;
+    for (; e; e >>= 1, a = nttMul(a, a))
+        if (e & 1) r = nttMul(r, a);
+    return r;
+}
+
+// In-place transform of a power-of-two length; the inverse includes the 1/len scaling
+inline void ntt(vector<u64>& a, bool invert) {
+    size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) swap(a[i], a[j]);
+    }
+    vector<u64> w(n / 2);
+    for (size_t len = 2; len <= n; len <<= 1) {
+        u64 wl = nttPow(7, (NTT_P - 1) / len); // 7 generates the multiplicative group
+        if (invert) wl = nttPow(wl, NTT_P - 2);
+        size_t half = len / 2;
+        w[0] = 1;
+        for (size_t j = 1; j < half; j++) w[j] = nttMul(w[j - 1], wl);
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                u64 u = a[i + j], v = nttMul(a[i + j + half], w[j]);
+                a[i + j] = nttAdd(u, v);
+                a[i + j + half] = nttSub(u, v);
+            }
+        }
+    }
+    if (invert) {
+        u64 inv = nttPow(n % NTT_P, NTT_P - 2);
+        for (auto& x : a) x = nttMul(x, inv);
+    }
+}
+
+// r[0..na+nb) = a * b through the NTT; b == a (same pointer and length) squares with one transform
+inline void mulNTT(u64* r, const u64* a, int na, const u64* b, int nb) {
+    size_t digits = 4 * (size_t)(na + nb), len = 1;
+    while (len < digits) len <<= 1;
+    auto load = [len](const u64* x, int n) {
+        vector<u64> d(len, 0);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < 4; j++) d[4 * i + j] = (x[i] >> (16 * j)) & 0xffff;
+        return d;
+    };
+    vector<u64> fa = load(a, na);
+    ntt(fa, false);
+    if (a == b && na == nb) {
+        for (auto& x : fa) x = nttMul(x, x);
+    } else {
+        vector<u64> fb = load(b, nb);
+        ntt(fb, false);
+        for (size_t i = 0; i < len; i++) fa[i] = nttMul(fa[i], fb[i]);
+    }
+    ntt(fa, true);
+    u128 carry = 0;
+    for (int i = 0; i < na + nb; i++) {
+        u64 limb = 0;
+        for (int j = 0; j < 4; j++) {
+            carry += fa[4 * i + j];
+            limb |= (u64)(carry & 0xffff) << (16 * j);
+            carry >>= 16;
+        }
+        r[i] = limb;
+    }
+}
+
+// Operand size (in limbs, of the shorter factor) from which mulMag switches to the NTT
+inline int nttThreshold = 8192;
+
+// Divisor size (in limbs) from which division uses a Newton reciprocal instead of Algorithm D
+inline int newtonThreshold = 2048;
+
+// ---- BigInt ----
+
+struct BigInt {
+    bool neg = false;
+    vector<u64> mag;
+
+    BigInt() {}
+    BigInt(long long v) {
+        neg = v < 0;
+        u64 m = neg ? (u64)0 - (u64)v : (u64)v;
+        if (m) mag.push_back(m);
+    }
+
+    bool isZero() const { return mag.empty(); }
+    bool isOdd() const { return !mag.empty() && (mag[0] & 1); }
+    int limbs() const { return (int)mag.size(); }
+
+    int bitLength() const {
+        if (mag.empty()) return 0;
+        return 64 * (int)(mag.size() - 1) + (64 - __builtin_clzll(mag.back()));
+    }
+
+    bool bit(int i) const {
+        int w = i / 64;
+        return w < (int)mag.size() && ((mag[w] >> (i % 64)) & 1);
+    }
+
+    // Low 64 bits of the magnitude (handy for small values and hashing)
+    u64 low() const { return mag.empty() ? 0 : mag[0]; }
+
+    // |this| mod m for a single-limb m (no BigInt temporaries; used by trial division and sieves)
+    u64 modU64(u64 m) const {
+        u64 r = 0;
+        for (int i = (int)mag.size() - 1; i >= 0; i--) r = (u64)((((u128)r << 64) | mag[i]) % m);
+        return r;
+    }
+
+    void trim() {
+        while (!mag.empty() && mag.back() == 0) mag.pop_back();
+        if (mag.empty()) neg = false;
+    }
+
+    static BigInt fromLimbs(vector<u64> limbs) {
+        BigInt r;
+        r.mag = move(limbs);
+        r.trim();
+        return r;
+    }
+
+    // ---- magnitude helpers ----
+
+    static int cmpMag(const vector<u64>& a, const vector<u64>& b) {
+        if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+        for (int i = (int)a.size() - 1; i >= 0; i--)
+            if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+        return 0;
+    }
+
+    static vector<u64> addMag(const vector<u64>& a, const vector<u64>& b) {
+        const vector<u64>& x = a.size() >= b.size() ? a : b;
+        const vector<u64>& y = a.size() >= b.size() ? b : a;
+        vector<u64> r(x.begin(), x.end());
+        r.push_back(0);
+        u64 carry = addLimbs(r.data(), y.data(), (int)y.size());
+        addCarry(r.data() + y.size(), (int)(r.size() - y.size()), carry);
+        return r;
+    }
+
+    // |a| - |b| assuming |a| >= |b|
+    static vector<u64> subMag(const vector<u64>& a, const vector<u64>& b) {
+        vector<u64> r(a);
+        u64 borrow = subLimbs(r.data(), b.data(), (int)b.size());
+        for (size_t i = b.size(); i < r.size() && borrow; i++) borrow = (r[i]-- == 0);
+        return r;
+    }
+
+    static vector<u64> mulMag(const vector<u64>& a, const vector<u64>& b) {
+        if (a.empty() || b.empty()) return {};
+        int na = (int)a.size(), nb = (int)b.size();
+        vector<u64> r(na + nb);
+        if (min(na, nb) < karatsubaCutoff()) {
+            mulSchoolbook(r.data(), a.data(), na, b.data(), nb);
+            return r;
+        }
+        if (min(na, nb) >= nttThreshold) {
+            mulNTT(r.data(), a.data(), na, &a == &b ? a.data() : b.data(), nb);
+            return r;
+        }
+        if (&a == &b) {
+            vector<u64> scratch(karatsubaScratch(na));
+            sqrKaratsuba(r.data(), a.data(), na, scratch.data());
+            return r;
+        }
+        // Split the longer operand into chunks the size of the shorter one
+        const vector<u64>& x = na >= nb ? a : b;
+        const vector<u64>& y = na >= nb ? b : a;
+        int n = (int)y.size();
+        vector<u64> chunk(n), part(2 * n), scratch(karatsubaScratch(n));
+        for (int off = 0; off < (int)x.size(); off += n) {
+            int len = min(n, (int)x.size() - off);
+            int plen = min(2 * n, len + n);
+            if (len == n) {
+                copy(x.begin() + off, x.begin() + off + len, chunk.begin());
+                mulKaratsuba(part.data(), chunk.data(), y.data(), n, scratch.data());
+            } else {
+                // short tail: multiply it at its own size instead of padding to n limbs
+                vector<u64> tail = mulMag(vector<u64>(x.begin() + off, x.begin() + off + len), y);
+                copy(tail.begin(), tail.end(), part.begin());
+            }
+            int room = (int)r.size() - off;
+            plen = min(plen, room);
+            u64 carry = addLimbs(r.data() + off, part.data(), plen);
+            addCarry(r.data() + off + plen, room - plen, carry);
+        }
+        return r;
+    }
+
+    // Knuth Algorithm D: q = |a| / |b|, r = |a| % |b|, b non-zero
+    static void divModMag(const vector<u64>& a, const vector<u64>& b, vector<u64>& q, vector<u64>& r) {
+        if (cmpMag(a, b) < 0) {
+            q.clear();
+            r = a;
+            return;
+        }
+        if (b.size() == 1) {
+            q.assign(a.size(), 0);
+            u64 rem = 0;
+            for (int i = (int)a.size() - 1; i >= 0; i--) {
+                u128 cur = ((u128)rem << 64) | a[i];
+                q[i] = (u64)(cur / b[0]);
+                rem = (u64)(cur % b[0]);
+            }
+            r.assign(1, rem);
+            return;
+        }
+        int s = __builtin_clzll(b.back());
+        int n = (int)b.size(), m = (int)a.size() - n;
+        vector<u64> bn(n), an(a.size() + 1);
+        for (int i = n - 1; i > 0; i--) bn[i] = (b[i] << s) | (s ? b[i - 1] >> (64 - s) : 0);
+        bn[0] = b[0] << s;
+        an[a.size()] = s ? a.back() >> (64 - s) : 0;
+        for (int i = (int)a.size() - 1; i > 0; i--) an[i] = (a[i] << s) | (s ? a[i - 1] >> (64 - s) : 0);
+        an[0] = a[0] << s;
+
+        q.assign(m + 1, 0);
+        u64 d = bn[n - 1], d2 = bn[n - 2];
+        for (int j = m; j >= 0; j--) {
+            u128 num = ((u128)an[j + n] << 64) | an[j + n - 1];
+            u128 qhat = num / d;
+            if (qhat > ~(u64)0) qhat = ~(u64)0;
+            u128 rhat = num - qhat * d;
+            while (rhat <= ~(u64)0 && qhat * d2 > ((rhat << 64) | an[j + n - 2])) {
+                qhat--;
+                rhat += d;
+            }
+            // an[j..j+n] -= qhat * bn
+            u64 borrow = 0, carry = 0;
+            for (int i = 0; i < n; i++) {
+                u128 p = qhat * bn[i] + carry;
+                carry = (u64)(p >> 64);
+                u128 t = (u128)an[i + j] - (u64)p - borrow;
+                an[i + j] = (u64)t;
+                borrow = (u64)(t >> 64) ? 1 : 0;
+            }
+            u128 t = (u128)an[j + n] - carry - borrow;
+            an[j + n] = (u64)t;
+            if ((u64)(t >> 64)) {
+                // qhat was one too large: add the divisor back
+                qhat--;
+                u64 c = addLimbs(an.data() + j, bn.data(), n);
+                an[j + n] += c;
+            }
+            q[j] = (u64)qhat;
+        }
+        r.assign(n, 0);
+        for (int i = 0; i < n; i++) r[i] = (an[i] >> s) | (s ? an[i + 1] << (64 - s) : 0);
+        while (!q.empty() && q.back() == 0) q.pop_back();
+        while (!r.empty() && r.back() == 0) r.pop_back();
+    }
+
+    // ---- arithmetic ----
+
+    friend BigInt operator-(const BigInt& a) {
+        BigInt r = a;
+        if (!r.isZero()) r.neg = !r.neg;
+        return r;
+    }
+
+    friend BigInt operator+(const BigInt& a, const BigInt& b) {
+        BigInt r;
+        if (a.neg == b.neg) {
+            r.mag = addMag(a.mag, b.mag);
+            r.neg = a.neg;
+        } else if (cmpMag(a.mag, b.mag) >= 0) {
+            r.mag = subMag(a.mag, b.mag);
+            r.neg = a.neg;
+        } else {
+            r.mag = subMag(b.mag, a.mag);
+            r.neg = b.neg;
+        }
+        r.trim();
+        return r;
+    }
+
+    friend BigInt operator-(const BigInt& a, const BigInt& b) { return a + (-b); }
+
+    friend BigInt operator*(const BigInt& a, const BigInt& b) {
+        BigInt r;
+        r.mag = &a == &b ? mulMag(a.mag, a.mag) : mulMag(a.mag, b.mag);
+        r.neg = a.neg != b.neg;
+        r.trim();
+        return r;
+    }
+
+    // floor(B^(2k) / m) for a positive m of k limbs, B = 2^64.
+    // Recursively gets a half-precision estimate from the top limbs of m, then one
+    // Newton step x += x * (B^2k - m*x) / B^2k doubles the correct digits and a
+    // final exact correction fixes the last few units. Cost is a few k-limb
+    // multiplications, so it inherits the speed of Karatsuba / NTT.
+    static BigInt reciprocal(const BigInt& m) {
+        int k = m.limbs();
+        if (k < max(newtonThreshold, 8)) {
+            BigInt q, r;
+            divModMag((BigInt(1) << (128 * k)).mag, m.mag, q.mag, r.mag);
+            return q;
+        }
+        int h = (k + 1) / 2 + 2; // enough guard limbs that the Newton step lands within a few units
+        BigInt x = reciprocal(m >> (64 * (k - h))) << (64 * (k - h));
+        BigInt top = BigInt(1) << (128 * k);
+        BigInt e = top - m * x;
+        x += (x * e) >> (128 * k);
+        e = top - m * x;
+        while (e.neg) {
+            x -= 1;
+            e += m;
+        }
+        while (e >= m) {
+            x += 1;
+            e -= m;
+        }
+        return x;
+    }
+
+    // q = a / m, r = a % m for 0 <= a, with mu = reciprocal(m): Barrett reduction
+    // over k-limb chunks of a, so every step divides a value below m * B^k.
+    static void divModBarrett(const BigInt& a, const BigInt& m, const BigInt& mu, BigInt& q, BigInt& r) {
+        int k = m.limbs();
+        int chunks = (a.limbs() + k - 1) / k;
+        q = 0;
+        r = 0;
+        for (int c = chunks - 1; c >= 0; c--) {
+            vector<u64> part(a.mag.begin() + (size_t)c * k, a.mag.begin() + min((size_t)(c + 1) * k, a.mag.size()));
+            BigInt cur = (r << (64 * k)) + fromLimbs(move(part));
+            BigInt qc = ((cur >> (64 * (k - 1))) * mu) >> (64 * (k + 1));
+            r = cur - qc * m;
+            while (r >= m) {
+                r -= m;
+                qc += 1;
+            }
+            q = (q << (64 * k)) + qc;
+        }
+    }
+
+    static void divMod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+        if (b.isZero()) throw domain_error("BigInt division by zero");
+        if (b.limbs() >= newtonThreshold && a.limbs() - b.limbs() >= newtonThreshold / 2) {
+            BigInt ua = a, ub = b;
+            ua.neg = ub.neg = false;
+            divModBarrett(ua, ub, reciprocal(ub), q, r);
+        } else {
+            divModMag(a.mag, b.mag, q.mag, r.mag);
+        }
+        q.neg = a.neg != b.neg;
+        r.neg = a.neg;
+        q.trim();
+        r.trim();
+    }
+
+    friend BigInt operator/(const BigInt& a, const BigInt& b) {
+        BigInt q, r;
+        divMod(a, b, q, r);
+        return q;
+    }
+
+    friend BigInt operator%(const BigInt& a, const BigInt& b) {
+        BigInt q, r;
+        divMod(a, b, q, r);
+        return r;
+    }
+
+    friend BigInt operator<<(const BigInt& a, int s) {
+        if (a.isZero()) return a;
+        int w = s / 64, bits = s % 64;
+        BigInt r;
+        r.neg = a.neg;
+        r.mag.assign(a.mag.size() + w + 1, 0);
+        for (size_t i = 0; i < a.mag.size(); i++) {
+            r.mag[i + w] |= a.mag[i] << bits;
+            if (bits) r.mag[i + w + 1] |= a.mag[i] >> (64 - bits);
+        }
+        r.trim();
+        return r;
+    }
+
+    // Shifts the magnitude (for non-negative values this is floor division by 2^s)
+    friend BigInt operator>>(const BigInt& a, int s) {
+        int w = s / 64, bits = s % 64;
+        if (w >= (int)a.mag.size()) return BigInt();
+        BigInt r;
+        r.neg = a.neg;
+        r.mag.assign(a.mag.size() - w, 0);
+        for (size_t i = 0; i < r.mag.size(); i++) {
+            r.mag[i] = a.mag[i + w] >> bits;
+            if (bits && i + w + 1 < a.mag.size()) r.mag[i] |= a.mag[i + w + 1] << (64 - bits);
+        }
+        r.trim();
+        return r;
+    }
+
+    BigInt& operator+=(const BigInt& b) { return *this = *this + b; }
+    BigInt& operator-=(const BigInt& b) { return *this = *this - b; }
+    BigInt& operator*=(const BigInt& b) { return *this = *this * b; }
+    BigInt& operator/=(const BigInt& b) { return *this = *this / b; }
+    BigInt& operator%=(const BigInt& b) { return *this = *this % b; }
+    BigInt& operator<<=(int s) { return *this = *this << s; }
+    BigInt& operator>>=(int s) { return *this = *this >> s; }
+
+    friend int compare(const BigInt& a, const BigInt& b) {
+        if (a.neg != b.neg) return a.neg ? -1 : 1;
+        int c = cmpMag(a.mag, b.mag);
+        return a.neg ? -c : c;
+    }
+    friend bool operator==(const BigInt& a, const BigInt& b) { return a.neg == b.neg && a.mag == b.mag; }
+    friend bool operator!=(const BigInt& a, const BigInt& b) { return !(a == b); }
+    friend bool operator<(const BigInt& a, const BigInt& b) { return compare(a, b) < 0; }
+    friend bool operator>(const BigInt& a, const BigInt& b) { return compare(a, b) > 0; }
+    friend bool operator<=(const BigInt& a, const BigInt& b) { return compare(a, b) <= 0; }
+    friend bool operator>=(const BigInt& a, const BigInt& b) { return compare(a, b) >= 0; }
+
+    // ---- conversion ----
+
+    // Parses decimal, or hexadecimal with a 0x prefix; an optional leading '-'
+    static BigInt fromString(const string& s) {
+        BigInt r;
+        size_t i = 0;
+        bool negative = false;
+        if (i < s.size() && (s[i] == '-' || s[i] == '+')) negative = s[i++] == '-';
+        if (s.size() > i + 1 && s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+            for (i += 2; i < s.size(); i++) {
+                int v = isdigit(s[i]) ? s[i] - '0' : tolower(s[i]) - 'a' + 10;
+                if (v < 0 || v > 15) throw invalid_argument("bad hex digit in BigInt");
+                r = (r << 4) + BigInt(v);
+            }
+        } else {
+            const u64 CHUNK = 1000000000000000000ULL; // 10^18
+            for (; i < s.size(); i += 18) {
+                size_t len = min((size_t)18, s.size() - i);
+                u64 v = 0, scale = 1;
+                for (size_t j = i; j < i + len; j++) {
+                    if (!isdigit(s[j])) throw invalid_argument("bad decimal digit in BigInt");
+                    v = v * 10 + (s[j] - '0');
+                    scale *= 10;
+                }
+                r.mulSmallAdd(len == 18 ? CHUNK : scale, v);
+            }
+        }
+        r.neg = negative;
+        r.trim();
+        return r;
+    }
+
+    // this = this * m + a, for single-limb m and a (magnitude only)
+    void mulSmallAdd(u64 m, u64 a) {
+        u64 carry = a;
+        for (auto& limb : mag) {
+            u128 t = (u128)limb * m + carry;
+            limb = (u64)t;
+            carry = (u64)(t >> 64);
+        }
+        if (carry) mag.push_back(carry);
+    }
+
+    string toString() const {
+        if (isZero()) return "0";
+        vector<u64> cur = mag;
+        vector<u64> parts; // base 10^18 digits, least significant first
+        const u64 CHUNK = 1000000000000000000ULL;
+        while (!cur.empty()) {
+            u64 rem = 0;
+            for (int i = (int)cur.size() - 1; i >= 0; i--) {
+                u128 t = ((u128)rem << 64) | cur[i];
+                cur[i] = (u64)(t / CHUNK);
+                rem = (u64)(t % CHUNK);
+            }
+            while (!cur.empty() && cur.back() == 0) cur.pop_back();
+            parts.push_back(rem);
+        }
+        string s = neg ? "-" : "";
+        s += to_string(parts.back());
+        for (int i = (int)parts.size() - 2; i >= 0; i--) {
+            string p = to_string(parts[i]);
+            s += string(18 - p.size(), '0') + p;
+        }
+        return s;
+    }
+
+    string toHex() const {
+        if (isZero()) return "0x0";
+        static const char* digits = "0123456789abcdef";
+        string s;
+        for (int i = bitLength() - 1 - (bitLength() - 1) % 4; i >= 0; i -= 4) {
+            int v = 0;
+            for (int j = 3; j >= 0; j--) v = v * 2 + bit(i + j);
+            s += digits[v];
+        }
+        return (neg ? "-0x" : "0x") + s;
+    }
+
+    friend ostream& operator<<(ostream& os, const BigInt& a) { return os << a.toString(); }
+    friend istream& operator>>(istream& is, BigInt& a) {
+        string s;
+        if (!(is >> s)) return is;
+        try {
+            a = fromString(s);
+        } catch (const invalid_argument&) {
+            is.setstate(ios::failbit);   // like "abc" into a long long: a failed read, not an abort
+        }
+        return is;
+    }
+};
+
+// Uniform random integer with exactly `bits` bits (top bit set)
+template <class RNG>
+BigInt randomBits(int bits, RNG& rng) {
+    vector<u64> limbs((bits + 63) / 64);
+    for (auto& l : limbs) l = rng();
+    int top = bits % 64;
+    if (top) limbs.back() &= (~0ULL >> (64 - top));
+    limbs.back() |= 1ULL << ((bits - 1) % 64);
+    return BigInt::fromLimbs(limbs);
+}
+
+// Uniform random integer in [0, bound)
+template <class RNG>
+BigInt randomBelow(const BigInt& bound, RNG& rng) {
+    vector<u64> limbs(bound.limbs());
+    for (auto& l : limbs) l = rng();
+    return BigInt::fromLimbs(limbs) % bound;
+}
+
+// ---- Montgomery arithmetic for multi-limb odd moduli ----
+
+// Values are fixed-size vectors of k limbs in Montgomery form (x * R mod n, R = 2^(64k)).
+// The context is read-only after construction; products go through per-thread
+// buffers, so one context can be shared by many threads.
+struct BigMontgomery {
+    int k;
+    vector<u64> n;     // modulus limbs (k limbs, odd)
+    u64 n0;            // -n^{-1} mod 2^64
+    vector<u64> r2;    // R^2 mod n
+    vector<u64> one;   // R mod n
+
+    explicit BigMontgomery(const BigInt& mod) {
+        if (!mod.isOdd()) throw invalid_argument("BigMontgomery needs an odd modulus");
+        k = mod.limbs();
+        n = mod.mag;
+        u64 inv = n[0];
+        for (int i = 0; i < 5; i++) inv *= 2 - n[0] * inv;
+        n0 = (u64)0 - inv;
+        r2 = pad((BigInt(1) << (128 * k)) % mod);
+        one = pad((BigInt(1) << (64 * k)) % mod);
+    }
+
+    vector<u64> pad(const BigInt& x) const {
+        vector<u64> v(x.mag);
+        v.resize(k, 0);
+        return v;
+    }
+
+    // Product buffer (2k+1 limbs) followed by Karatsuba scratch, one per thread
+    u64* workspace() const {
+        static thread_local vector<u64> buf;
+        size_t need = 2 * k + 1 + karatsubaScratch(k);
+        if (buf.size() < need) buf.assign(need, 0);
+        return buf.data();
+    }
+
+    // out = T[0..2k] * R^{-1} mod n (word-by-word REDC); T is clobbered
+    void redc(u64* T, u64* out) const {
+        T[2 * k] = 0;
+        for (int i = 0; i < k; i++) {
+            u64 m = T[i] * n0;
+            u64 carry = 0;
+            for (int j = 0; j < k; j++) {
+                u128 x = (u128)m * n[j] + T[i + j] + carry;
+                T[i + j] = (u64)x;
+                carry = (u64)(x >> 64);
+            }
+            addCarry(T + i + k, k + 1 - i, carry);
+        }
+        // result T[k..2k] < 2n: subtract n unconditionally into T[0..k),
+        // then keep whichever of the two is in range, without branching
+        u64 borrow = 0;
+        for (int j = 0; j < k; j++) {
+            u128 x = (u128)T[k + j] - n[j] - borrow;
+            T[j] = (u64)x;
+            borrow = (u64)(x >> 64) ? 1 : 0;
+        }
+        u64 keepSub = (u64)0 - (u64)((T[2 * k] | (borrow ^ 1)) != 0);
+        for (int j = 0; j < k; j++) out[j] = (T[j] & keepSub) | (T[k + j] & ~keepSub);
+    }
+
+    void mul(u64* out, const u64* a, const u64* b) const {
+        u64* T = workspace();
+        if (k < karatsubaCutoff()) mulSchoolbook(T, a, k, b, k);
+        else mulKaratsuba(T, a, b, k, T + 2 * k + 1);
+        redc(T, out);
+    }
+
+    void sqr(u64* out, const u64* a) const {
+        u64* T = workspace();
+        if (k < karatsubaCutoff()) sqrSchoolbook(T, a, k);
+        else sqrKaratsuba(T, a, k, T + 2 * k + 1);
+        redc(T, out);
+    }
+
+    vector<u64> toMont(const BigInt& x) const {
+        vector<u64> a = pad(x % BigInt::fromLimbs(n)), r(k);
+        mul(r.data(), a.data(), r2.data());
+        return r;
+    }
+
+    BigInt fromMont(const vector<u64>& a) const {
+        vector<u64> T(2 * k + 1, 0), r(k);
+        copy(a.begin(), a.end(), T.begin());
+        redc(T.data(), r.data());
+        return BigInt::fromLimbs(r);
+    }
+
+    // Engine interface (see slidingWindowPow in modarith.h)
+    void mulInto(vector<u64>& out, const vector<u64>& a, const vector<u64>& b) const {
+        out.resize(k);
+        mul(out.data(), a.data(), b.data());
+    }
+    void sqrInto(vector<u64>& out, const vector<u64>& a) const {
+        out.resize(k);
+        sqr(out.data(), a.data());
+    }
+    void select(vector<u64>& out, const vector<vector<u64>>& table, u64 idx) const {
+        out.assign(k, 0);
+        for (size_t i = 0; i < table.size(); i++) {
+            u64 mask = (u64)0 - (u64)(i == idx);
+            for (int j = 0; j < k; j++) out[j] |= table[i][j] & mask;
+        }
+    }
+
+    // base^exp mod n for a plain (non-Montgomery) base; sliding-window exponentiation
+    BigInt pow(const BigInt& base, const BigInt& exp) const {
+        if (exp.isZero()) return BigInt(1) % BigInt::fromLimbs(n);
+        vector<u64> a = toMont(base);
+        return fromMont(slidingWindowPow(*this, a, exp.bitLength(), [&exp](int i) { return exp.bit(i); }));
+    }
+
+    // Same as pow for a secret exponent: fixed windows over max(exp bits, modulus bits)
+    BigInt powConstTime(const BigInt& base, const BigInt& exp) const {
+        vector<u64> a = toMont(base);
+        int bits = max(exp.bitLength(), 64 * k);
+        return fromMont(fixedWindowPow(*this, a, bits, [&exp](int i) { return exp.bit(i); }));
+    }
+};
+
+// ---- gcd / power / modInverse on BigInt (same contracts as modarith.h) ----
+
+inline BigInt gcd(BigInt a, BigInt b) {
+    a.neg = b.neg = false;
+    while (!b.isZero()) {
+        BigInt t = a % b;
+        a = move(b);
+        b = move(t);
+    }
+    return a;
+}
+
+// Fast modular exponentiation: (a^b) % mod, b >= 0
+inline BigInt power(BigInt a, const BigInt& b, const BigInt& mod) {
+    if (mod == BigInt(1)) return BigInt(0);
+    a %= mod;
+    if (a.neg) a += mod;
+    if (mod.isOdd()) return BigMontgomery(mod).pow(a, b);
+    BigInt res = 1;
+    for (int i = b.bitLength() - 1; i >= 0; i--) {
+        res = res * res % mod;
+        if (b.bit(i)) res = res * a % mod;
+    }
+    return res;
+}
+
+// (a^b) % mod for a secret exponent b (fixed-window, odd moduli only; even moduli use power)
+inline BigInt powerConstTime(BigInt a, const BigInt& b, const BigInt& mod) {
+    if (mod == BigInt(1)) return BigInt(0);
+    if (!mod.isOdd()) return power(a, b, mod);
+    a %= mod;
+    if (a.neg) a += mod;
+    return BigMontgomery(mod).powConstTime(a, b);
+}
+
+// Modular inverse using the Extended Euclidean Algorithm
+// Returns x such that (a * x) % m == 1 when gcd(a,m) == 1
+inline BigInt modInverseEuclid(BigInt a, BigInt m) {
+    BigInt m0 = m, y = 0, x = 1;
+    if (m == BigInt(1)) return BigInt(0);
+    a %= m;
+    if (a.neg) a += m;
+
+    while (a > BigInt(1)) {
+        BigInt q, r;
+        BigInt::divMod(a, m, q, r);
+        a = move(m);
+        m = move(r);
+        BigInt t = y;
+        y = x - q * y;
+        x = move(t);
+    }
+
+    if (x.neg) x += m0;
+    return x;
+}
+
+// ---- Lehmer extended GCD ----
+//
+// Euclid on multi-limb numbers pays one long division per quotient, and most quotients
+// are tiny. Lehmer runs the quotient sequence on the leading 62 bits of (u, v) in
+// single words, for as long as the approximation provably matches the real sequence
+// (Knuth, TAOCP 4.5.2, Algorithm L), and then applies the accumulated 2x2 matrix to the
+// full numbers in one linear pass. Each round retires about 30 bits.
+
+// Bits [shift, shift + 62) of a non-negative x
+inline long long lehmerTop(const BigInt& x, int shift) {
+    int w = shift / 64, b = shift % 64;
+    u64 lo = w < x.limbs() ? x.mag[w] >> b : 0;
+    if (b && w + 1 < x.limbs()) lo |= x.mag[w + 1] << (64 - b);
+    return (long long)(lo & ((1ULL << 62) - 1));
+}
+
+// A*x + B*y for non-negative x, y and word coefficients of opposite signs (or one zero)
+// whose result is known to be non-negative
+inline BigInt lehmerCombine(const BigInt& x, long long A, const BigInt& y, long long B) {
+    size_t n = max(x.mag.size(), y.mag.size());
+    vector<u64> out(n + 1);
+    __int128 acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i < x.mag.size()) acc += (__int128)A * (__int128)x.mag[i];
+        if (i < y.mag.size()) acc += (__int128)B * (__int128)y.mag[i];
+        out[i] = (u64)acc;
+        acc >>= 64;
+    }
+    out[n] = (u64)acc;
+    return BigInt::fromLimbs(move(out));
+}
+
+// x * c for a signed word c
+inline BigInt mulWord(BigInt x, long long c) {
+    if (c == 0 || x.isZero()) return BigInt();
+    x.mulSmallAdd(c < 0 ? (u64)0 - (u64)c : (u64)c, 0);
+    if (c < 0) x.neg = !x.neg;
+    return x;
+}
+
+// Modular inverse by Lehmer's extended GCD; same contract as modInverseEuclid.
+// Returns 0 when gcd(a, m) != 1.
+inline BigInt modInverseLehmer(BigInt a, BigInt m) {
+    if (m.neg) m.neg = false;
+    if (m == BigInt(1)) return BigInt(0);
+    a %= m;
+    if (a.neg) a += m;
+    // invariants: xu * a == u, xv * a == v (mod m), u > v >= 0
+    BigInt u = m, v = a, xu = 0, xv = 1;
+    while (v.bitLength() > 62) {
+        int shift = max(u.bitLength() - 62, 0);
+        long long uh = lehmerTop(u, shift), vh = lehmerTop(v, shift);
+        long long A = 1, B = 0, C = 0, D = 1;
+        while (vh + C > 0 && vh + D > 0) {
+            long long q = (uh + A) / (vh + C);
+            if (q != (uh + B) / (vh + D)) break;
+            long long t = A - q * C;
+            A = C, C = t;
+            t = B - q * D;
+            B = D, D = t;
+            t = uh - q * vh;
+            uh = vh, vh = t;
+        }
+        if (B == 0) {
+            // the leading words could not predict even one quotient: one full division step
+            BigInt q, r;
+            BigInt::divMod(u, v, q, r);
+            u = move(v);
+            v = move(r);
+            BigInt t = xu - q * xv;
+            xu = move(xv);
+            xv = move(t);
+        } else {
+            BigInt nu = lehmerCombine(u, A, v, B), nv = lehmerCombine(u, C, v, D);
+            u = move(nu), v = move(nv);
+            BigInt nxu = mulWord(xu, A) + mulWord(xv, B), nxv = mulWord(xu, C) + mulWord(xv, D);
+            xu = move(nxu), xv = move(nxv);
+        }
+    }
+    if (u.bitLength() > 62) {
+        if (v.isZero()) return BigInt(0);   // gcd = u > 1
+        BigInt q, r;
+        BigInt::divMod(u, v, q, r);
+        u = move(v);
+        v = move(r);
+        BigInt t = xu - q * xv;
+        xu = move(xv);
+        xv = move(t);
+    }
+    // both fit in a word now: finish in single precision and apply the matrix once
+    long long uw = (long long)u.low(), vw = (long long)v.low();
+    long long A = 1, B = 0, C = 0, D = 1;
+    while (vw != 0) {
+        long long q = uw / vw, t = uw - q * vw;
+        uw = vw, vw = t;
+        t = A - q * C;
+        A = C, C = t;
+        t = B - q * D;
+        B = D, D = t;
+    }
+    if (uw != 1) return BigInt(0);
+    BigInt x = (mulWord(xu, A) + mulWord(xv, B)) % m;
+    if (x.neg) x += m;
+    return x;
+}
+
+// ---- Constant-time inversion (Bernstein-Yang safegcd) ----
+//
+// For secret inputs (e.g. a nonce k^-1 or a blinding factor): the divstep recurrence
+//     delta > 0 and g odd:  (delta, f, g) -> (1 - delta, g, (g - f) / 2)
+//     otherwise:            (delta, f, g) -> (1 + delta, f, (g + (g & 1) * f) / 2)
+// reaches g = 0, f = +-gcd after a number of steps bounded by the bit length alone
+// ("Fast constant-time gcd computation and modular inversion", 2019, Theorem 11.2).
+// Steps run in batches of 62 on the low words with masks instead of branches; each
+// batch yields a 2x2 matrix (scaled by 2^62) that is applied to the full f, g and to
+// the cofactors d, e, which are kept mod m by adding the multiple of m that makes the
+// division by 2^62 exact. The step count, loop trip counts and memory accesses depend
+// only on the size of m, never on a.
+// Numbers use signed 62-bit limbs: value = sum l[i] * 2^(62 i), l[i] in [0, 2^62) except
+// the top limb, which carries the sign.
+
+const long long SAFEGCD_MASK = (1LL << 62) - 1;
+
+struct SafeGcdMatrix {
+    long long u, v, q, r;
+};
+
+inline vector<long long> toSigned62(const BigInt& x, int limbs) {
+    vector<long long> out(limbs, 0);
+    for (int i = 0; i < limbs; i++) {
+        int bit = 62 * i, w = bit / 64, b = bit % 64;
+        u64 lo = w < x.limbs() ? x.mag[w] >> b : 0;
+        if (b > 2 && w + 1 < x.limbs()) lo |= x.mag[w + 1] << (64 - b);
+        out[i] = (long long)(lo & SAFEGCD_MASK);
+    }
+    return out;
+}
+
+// Non-negative signed-62 value (all limbs in [0, 2^62)) back to a BigInt
+inline BigInt fromSigned62(const vector<long long>& l) {
+    vector<u64> mag((62 * l.size() + 63) / 64 + 1, 0);
+    for (size_t i = 0; i < l.size(); i++) {
+        int bit = 62 * (int)i, w = bit / 64, b = bit % 64;
+        mag[w] |= (u64)l[i] << b;
+        if (b > 2) mag[w + 1] |= (u64)l[i] >> (64 - b);
+    }
+    return BigInt::fromLimbs(move(mag));
+}
+
+// 62 divsteps on the low words of f and g (f odd); returns the new delta
+inline long long safegcdDivsteps(long long delta, u64 f, u64 g, SafeGcdMatrix& t) {
+    long long u = 1, v = 0, q = 0, r = 1;   // 2^i * (f_i, g_i) = (u f + v g, q f + r g)
+    for (int i = 0; i < 62; i++) {
+        u64 c1 = (u64)((0 - delta) >> 63);   // delta > 0
+        u64 c2 = 0 - (g & 1);                // g odd
+        u64 x = c1 & c2;
+        // when x: (f, g, u, v, q, r, delta) = (g, -f, q, r, -u, -v, -delta)
+        u64 nf = f ^ ((f ^ g) & x), ng = g ^ ((g ^ (0 - f)) & x);
+        long long lx = (long long)x;
+        long long nu = u ^ ((u ^ q) & lx), nq = q ^ ((q ^ -u) & lx);
+        long long nv = v ^ ((v ^ r) & lx), nr = r ^ ((r ^ -v) & lx);
+        f = nf, g = ng, u = nu, q = nq, v = nv, r = nr;
+        delta = (delta ^ lx) - lx;
+        long long lc2 = (long long)c2;
+        g += f & c2;
+        q += u & lc2;
+        r += v & lc2;
+        delta++;
+        g >>= 1;
+        u *= 2;
+        v *= 2;
+    }
+    t = {u, v, q, r};
+    return delta;
+}
+
+// (f, g) = (u f + v g, q f + r g) / 2^62, exact
+inline void safegcdUpdateFG(vector<long long>& f, vector<long long>& g, const SafeGcdMatrix& t) {
+    int n = (int)f.size();
+    __int128 cf = (__int128)t.u * f[0] + (__int128)t.v * g[0];
+    __int128 cg = (__int128)t.q * f[0] + (__int128)t.r * g[0];
+    cf >>= 62;
+    cg >>= 62;
+    for (int i = 1; i < n; i++) {
+        cf += (__int128)t.u * f[i] + (__int128)t.v * g[i];
+        cg += (__int128)t.q * f[i] + (__int128)t.r * g[i];
+        f[i - 1] = (long long)cf & SAFEGCD_MASK;
+        g[i - 1] = (long long)cg & SAFEGCD_MASK;
+        cf >>= 62;
+        cg >>= 62;
+    }
+    f[n - 1] = (long long)cf;
+    g[n - 1] = (long long)cg;
+}
+
+// (d, e) = (u d + v e, q d + r e) / 2^62 mod m, keeping both in (-2m, m)
+inline void safegcdUpdateDE(vector<long long>& d, vector<long long>& e, const SafeGcdMatrix& t,
+                            const vector<long long>& m, long long mInv62) {
+    int n = (int)d.size();
+    long long sd = d[n - 1] >> 63, se = e[n - 1] >> 63;
+    // start from m * (u [d < 0] + v [e < 0]) so the result cannot drop below -2m
+    long long md = (t.u & sd) + (t.v & se), me = (t.q & sd) + (t.r & se);
+    __int128 cd = (__int128)t.u * d[0] + (__int128)t.v * e[0];
+    __int128 ce = (__int128)t.q * d[0] + (__int128)t.r * e[0];
+    // adjust the multiples of m so the low 62 bits cancel
+    md -= (long long)((u64)(mInv62 * (u64)cd + md) & SAFEGCD_MASK);
+    me -= (long long)((u64)(mInv62 * (u64)ce + me) & SAFEGCD_MASK);
+    cd += (__int128)m[0] * md;
+    ce += (__int128)m[0] * me;
+    cd >>= 62;
+    ce >>= 62;
+    for (int i = 1; i < n; i++) {
+        cd += (__int128)t.u * d[i] + (__int128)t.v * e[i] + (__int128)m[i] * md;
+        ce += (__int128)t.q * d[i] + (__int128)t.r * e[i] + (__int128)m[i] * me;
+        d[i - 1] = (long long)cd & SAFEGCD_MASK;
+        e[i - 1] = (long long)ce & SAFEGCD_MASK;
+        cd >>= 62;
+        ce >>= 62;
+    }
+    d[n - 1] = (long long)cd;
+    e[n - 1] = (long long)ce;
+}
+
+// x += m when mask is all ones (x += 0 otherwise), then carries back into [0, 2^62) limbs
+inline void safegcdAddMasked(vector<long long>& x, const vector<long long>& m, long long mask) {
+    long long carry = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        long long s = x[i] + (m[i] & mask) + carry;
+        if (i + 1 < x.size()) {
+            carry = s >> 62;
+            s &= SAFEGCD_MASK;
+        }
+        x[i] = s;
+    }
+}
+
+// x = -x when mask is all ones
+inline void safegcdNegateMasked(vector<long long>& x, long long mask) {
+    long long carry = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        long long s = ((x[i] ^ mask) - mask) + carry;
+        if (i + 1 < x.size()) {
+            carry = s >> 62;
+            s &= SAFEGCD_MASK;
+        }
+        x[i] = s;
+    }
+}
+
+// a^{-1} mod m for an odd m and 0 <= a < m, in time that depends only on the size of m.
+// (a is reduced first when it is out of range, which is not constant-time.)
+// Returns 0 when gcd(a, m) != 1.
+inline BigInt modInverseConstTime(BigInt a, const BigInt& m) {
+    if (!m.isOdd() || m.neg) throw invalid_argument("safegcd inversion needs an odd positive modulus");
+    if (m == BigInt(1)) return BigInt(0);
+    if (a.neg || a >= m) {
+        a %= m;
+        if (a.neg) a += m;
+    }
+    int bits = m.bitLength();
+    int limbs = bits / 62 + 2;
+    int steps = bits < 46 ? (49 * bits + 80) / 17 : (49 * bits + 57) / 17;
+
+    vector<long long> mod = toSigned62(m, limbs), f = mod, g = toSigned62(a, limbs);
+    vector<long long> d(limbs, 0), e(limbs, 0);
+    e[0] = 1;   // invariants: f == d * a, g == e * a (mod m)
+    u64 inv = m.low();
+    for (int i = 0; i < 5; i++) inv *= 2 - m.low() * inv;
+    long long mInv62 = (long long)(inv & SAFEGCD_MASK);
+
+    long long delta = 1;
+    SafeGcdMatrix t;
+    for (int done = 0; done < steps; done += 62) {
+        delta = safegcdDivsteps(delta, (u64)f[0] | (u64)f[1] << 62, (u64)g[0] | (u64)g[1] << 62, t);
+        safegcdUpdateDE(d, e, t, mod, mInv62);
+        safegcdUpdateFG(f, g, t);
+    }
+
+    // now g = 0 and f = +-gcd(a, m); a^{-1} = sign(f) * d, brought into [0, m)
+    long long fNeg = f[limbs - 1] >> 63;
+    safegcdAddMasked(d, mod, d[limbs - 1] >> 63);
+    safegcdNegateMasked(d, fNeg);
+    safegcdAddMasked(d, mod, d[limbs - 1] >> 63);
+    safegcdNegateMasked(f, fNeg);
+    vector<long long> one(limbs, 0);
+    one[0] = 1;
+    if (f != one) return BigInt(0);   // not invertible (the only data-dependent branch, on a public fact)
+    return fromSigned62(d);
+}
+
+// Modular inverse (Lehmer); see modInverseEuclid for the contract
+inline BigInt modInverse(const BigInt& a, const BigInt& m) { return modInverseLehmer(a, m); }
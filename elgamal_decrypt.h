@@ -0,0 +1,99 @@
+/*
+    elgamal_decrypt.h — batch ElGamal decryption over large ciphertext arrays
+
+    Purpose:
+    - Decrypting (c1, c2) is m = c2 / c1^x. Done one ciphertext at a time that is
+        an exponentiation plus a modular inverse (extended GCD) each. Both methods
+        here remove the per-ciphertext inverse:
+        DecryptMethod::FoldExponent  m = c2 * c1^(p-1-x): c1^(p-1) = 1 for c1 != 0,
+            so the inverse folds into the exponent (one power, one multiplication).
+        DecryptMethod::BatchInverse  s_i = c1_i^x for a whole chunk, then all s_i
+            are inverted at once with Montgomery's trick (batchInverse): one
+            inversion plus 3(N-1) multiplications for N values.
+
+    Contents:
+    - batchInverse(mont, xs, n, scratch): in-place inverses of Montgomery-form values
+    - decryptRange(...): one thread, one contiguous range
+    - decryptBatch(...): the array cut into DECRYPT_CHUNK-sized ranges on a ThreadPool
+
+    Notes:
+    - Outputs are plain residues. Error records (c1 = 0, elgamal_file.h) and
+        values not below p give DECRYPT_ERROR (never a valid plaintext, which is < p).
+    - p must be an odd prime below 2^63 (64-bit Montgomery); x is used mod p-1.
+    - Both leave one exponentiation per ciphertext, which dominates: the batch
+        inversion adds ~12 ns per value on a 62-bit p, against ~0.4 us for the
+        power. The exponent p-1-x is as long as x, so FoldExponent is the default;
+        BatchInverse wins when x is much shorter than p (short-exponent keys).
+*/
+
+#pragma once
+
+#include "elgamal_file.h"
+#include "thread_pool.h"
+
+const size_t DECRYPT_CHUNK = 4096;   // ciphertexts per task (and per batch inversion)
+const u64 DECRYPT_ERROR = ~0ULL;     // output for records that do not decrypt
+
+enum class DecryptMethod { FoldExponent, BatchInverse };
+
+// xs[i] := xs[i]^-1 for n nonzero Montgomery-form values (scratch is resized to n).
+// Prefix products, one inversion of the total, then a backward pass peeling one factor at a time.
+inline void batchInverse(const Montgomery& mont, u64* xs, size_t n, vector<u64>& scratch) {
+    if (n == 0) return;
+    scratch.resize(n);
+    scratch[0] = xs[0];
+    for (size_t i = 1; i < n; i++) scratch[i] = mont.mul(scratch[i - 1], xs[i]);
+    // (a R)^-1 -> a^-1 R: invert the plain value, enter Montgomery form again
+    u64 inv = mont.toMont(modInverseBinary(mont.fromMont(scratch[n - 1]), mont.n));
+    for (size_t i = n - 1; i > 0; i--) {
+        u64 xi = xs[i];
+        xs[i] = mont.mul(inv, scratch[i - 1]);   // (x_0..x_i)^-1 * (x_0..x_{i-1}) = x_i^-1
+        inv = mont.mul(inv, xi);                 // now (x_0..x_{i-1})^-1
+    }
+    xs[0] = inv;
+}
+
+// out[i] = plaintext of cts[i] (or DECRYPT_ERROR)
+inline void decryptRange(const Montgomery& mont, u64 x, const CipherRecord* cts, size_t n, u64* out, DecryptMethod method) {
+    u64 p = mont.n, order = p - 1;
+    x %= order;
+    if (method == DecryptMethod::FoldExponent) {
+        u64 e = (order - x) % order;
+        for (size_t i = 0; i < n; i++) {
+            const CipherRecord& r = cts[i];
+            bool ok = r.c1 != 0 && r.c1 < p && r.c2 < p;
+            // plain c2 times Montgomery-form c1^e: the REDC leaves the plain product
+            out[i] = ok ? mont.mul(r.c2, mont.pow(mont.toMont(r.c1), e)) : DECRYPT_ERROR;
+        }
+        return;
+    }
+    // BatchInverse: shared secrets of the valid records, inverted together
+    static thread_local vector<u64> s, scratch;   // reused by every chunk on this thread
+    s.clear();
+    for (size_t i = 0; i < n; i++) {
+        const CipherRecord& r = cts[i];
+        if (r.c1 != 0 && r.c1 < p && r.c2 < p) s.push_back(mont.pow(mont.toMont(r.c1), x));
+    }
+    batchInverse(mont, s.data(), s.size(), scratch);
+    size_t j = 0;
+    for (size_t i = 0; i < n; i++) {
+        const CipherRecord& r = cts[i];
+        out[i] = r.c1 != 0 && r.c1 < p && r.c2 < p ? mont.mul(r.c2, s[j++]) : DECRYPT_ERROR;
+    }
+}
+
+// Decrypts n ciphertexts into out[0..n) on the pool; returns the number of error records
+inline size_t decryptBatch(u64 p, u64 x, const CipherRecord* cts, size_t n, u64* out, ThreadPool& pool,
+                           DecryptMethod method = DecryptMethod::FoldExponent) {
+    if (p < 3 || !(p & 1) || p >> 63) throw invalid_argument("decryptBatch needs an odd prime p < 2^63");
+    Montgomery mont(p);
+    long long chunks = (long long)((n + DECRYPT_CHUNK - 1) / DECRYPT_CHUNK);
+    atomic<size_t> errors(0);
+    parallelFor(pool, chunks, [&](long long c) {
+        size_t lo = (size_t)c * DECRYPT_CHUNK, len = min(DECRYPT_CHUNK, n - lo), bad = 0;
+        decryptRange(mont, x, cts + lo, len, out + lo, method);
+        for (size_t i = lo; i < lo + len; i++) bad += out[i] == DECRYPT_ERROR;
+        errors += bad;
+    });
+    return errors;
+}
@@ -0,0 +1,273 @@
+/*
+    elgamal_dlog.h — discrete logarithms in Z_p* for ElGamal key-recovery audits
+
+    Purpose:
+    - Recover x from h = g^x mod p, to show that a given p is (or is not) weak.
+        The cost is set by the largest prime factor q of the order of g, not by p:
+        Pohlig–Hellman splits the problem into one small discrete log per prime
+        power dividing the order, and each of those costs about sqrt(q).
+
+    Contents:
+    - BabyStepTable: compact open-addressing hash table for BSGS, 8 bytes per
+        entry (32-bit tag + 32-bit index) instead of a full 64-bit key, linear
+        probing in a power-of-two array at most half full. A tag hit is only a
+        candidate; bsgs confirms it with one exponentiation.
+    - bsgs(mont, g, h, n, x): baby-step giant-step for x in [0, n), sqrt(n) memory.
+    - pollardRho(mont, g, h, q, pool, x): Pollard's rho for g of prime order q, in
+        parallel by distinguished points (van Oorschot–Wiener). Every worker runs
+        the same r-adding walk (RHO_PARTITIONS multipliers g^u h^v) from its own
+        random start g^a h^b and reports the points whose hash has `dpBits` low
+        zero bits to one shared table; two walks that meet go on to the same next
+        distinguished point, where the collision a + b*x = a' + b'*x (mod q)
+        gives x.
+    - discreteLog(group, g, h, pool): Pohlig–Hellman over the factorization of
+        p - 1 that ElGamalGroup (elgamal_group.h) already computed for
+        isGenerator. It finds the order of g, solves x mod q^e one base-q digit at a
+        time (BSGS for q up to DLOG_BSGS_MAX_BITS bits, rho above), and joins the
+        residues by CRT. The report holds the time and work of every prime power.
+
+    Notes:
+    - p must be an odd prime below 2^63 (64-bit Montgomery).
+    - Rho needs about 1.25 * sqrt(q) steps (~11 ns each on one core): ~0.3 s for
+        a 48-bit q, ~10-25 s for the 61-bit q of a 62-bit safe prime.
+    - When h is not a power of g, discreteLog says so instead of returning x.
+*/
+
+#pragma once
+
+#include "elgamal_group.h"
+
+const int DLOG_BSGS_MAX_BITS = 40;   // prime orders up to this size use BSGS (2^20 baby steps, 16 MB)
+const int RHO_PARTITIONS = 32;       // multipliers of the r-adding walk (indexed by 5 hash bits)
+const int RHO_RESTART_FACTOR = 20;   // a walk with no distinguished point after this many * 2^dpBits steps restarts
+
+class BabyStepTable {
+public:
+    explicit BabyStepTable(size_t entries) {
+        size_t cap = 2;
+        while (cap < 2 * entries) cap <<= 1;   // load factor <= 1/2
+        shift = 64 - __builtin_ctzll(cap);
+        mask = cap - 1;
+        slots.assign(cap, Slot{0, EMPTY});
+    }
+
+    void insert(u64 key, uint32_t index) {
+        u64 hsh = key * 0x9e3779b97f4a7c15ULL;
+        for (size_t i = hsh >> shift;; i = (i + 1) & mask)
+            if (slots[i].index == EMPTY) {
+                slots[i] = Slot{(uint32_t)hsh, index};
+                return;
+            }
+    }
+
+    // Calls fn(index) for every entry whose tag matches key, until fn returns true
+    template <class F>
+    bool find(u64 key, F fn) const {
+        u64 hsh = key * 0x9e3779b97f4a7c15ULL;
+        for (size_t i = hsh >> shift; slots[i].index != EMPTY; i = (i + 1) & mask)
+            if (slots[i].tag == (uint32_t)hsh && fn(slots[i].index)) return true;
+        return false;
+    }
+
+    size_t bytes() const { return slots.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        uint32_t tag, index;   // low 32 bits of the key's hash (the slot comes from the high bits)
+    };
+    static const uint32_t EMPTY = UINT32_MAX;
+    vector<Slot> slots;
+    int shift;
+    size_t mask;
+};
+
+// Montgomery-form inverse of a nonzero Montgomery-form value
+inline u64 montInverse(const Montgomery& mont, u64 a) {
+    return mont.toMont(modInverseBinary(mont.fromMont(a), mont.n));
+}
+
+// g^x == h (Montgomery form) for some x in [0, n)? Sets x; `steps` counts baby + giant steps.
+inline bool bsgs(const Montgomery& mont, u64 g, u64 h, u64 n, u64& x, u64* steps = nullptr) {
+    u64 m = max<u64>(1, (u64)ceil(sqrt((double)n)));
+    while (m * m < n) m++;
+    if (m >= UINT32_MAX) throw invalid_argument("bsgs: range too large for the baby-step table");
+    BabyStepTable table((size_t)m);
+    u64 cur = mont.one;
+    for (u64 j = 0; j < m; j++) {
+        table.insert(cur, (uint32_t)j);
+        cur = mont.mul(cur, g);
+    }
+    u64 giant = montInverse(mont, cur);   // g^-m
+    u64 gamma = h, count = m;
+    bool found = false;
+    for (u64 i = 0; i < m && !found; i++, count++) {
+        found = table.find(gamma, [&](uint32_t j) {
+            u64 cand = i * m + j;
+            if (cand >= n || mont.pow(g, cand) != h) return false;   // tag collision
+            x = cand;
+            return true;
+        });
+        gamma = mont.mul(gamma, giant);
+    }
+    if (steps) *steps += count;
+    return found;
+}
+
+// g^x == h (Montgomery form) where g has prime order q; gives up after `maxSteps` walk steps in total
+// (0: 64 * sqrt(q)), which also ends the search when h is not a power of g.
+inline bool pollardRho(const Montgomery& mont, u64 g, u64 h, u64 q, ThreadPool& pool, u64& x, u64* steps = nullptr,
+                       u64 maxSteps = 0) {
+    if (q < 1000) return bsgs(mont, g, h, q, x, steps);   // too small for random walks to be meaningful
+    int bits = 64 - __builtin_clzll(q);
+    int dpBits = max(0, min(20, bits / 4 - 2));
+    u64 dpMask = (1ULL << dpBits) - 1;
+    if (maxSteps == 0) maxSteps = (u64)(64 * sqrt((double)q));
+
+    // the walk: X -> X * M[j], j from the hash of X; the same for every worker
+    mt19937_64 seedRng(random_device{}());
+    u64 mu[RHO_PARTITIONS], mv[RHO_PARTITIONS], M[RHO_PARTITIONS];
+    for (int j = 0; j < RHO_PARTITIONS; j++) {
+        mu[j] = seedRng() % q, mv[j] = seedRng() % q;
+        M[j] = mont.mul(mont.pow(g, mu[j]), mont.pow(h, mv[j]));
+    }
+
+    mutex m;
+    unordered_map<u64, pair<u64, u64>> points;   // distinguished X -> (a, b), guarded by m
+    atomic<bool> stop(false), found(false);
+    atomic<u64> total(0);
+    u64 result = 0;
+    unsigned seed = (unsigned)seedRng();
+    vector<future<void>> workers;
+    for (unsigned w = 0; w < pool.size(); w++) {
+        workers.push_back(pool.submit([&, w] {
+            mt19937_64 rng(seed + 0x9e3779b97f4a7c15ULL * (w + 1));
+            u64 local = 0;
+            while (!stop) {
+                u64 a = rng() % q, b = rng() % q;
+                u64 X = mont.mul(mont.pow(g, a), mont.pow(h, b));
+                for (u64 len = 0; !stop; len++) {
+                    u64 hsh = X * 0x9e3779b97f4a7c15ULL;   // top 5 bits pick the multiplier, bits 32.. mark DPs
+                    if (((hsh >> 32) & dpMask) == 0) {
+                        lock_guard<mutex> lock(m);
+                        auto [it, fresh] = points.try_emplace(X, a, b);
+                        if (!fresh && it->second.second != b) {
+                            // a + b x == a' + b' x  ->  x = (a - a') / (b' - b)  (mod q)
+                            long long da = ((long long)a - (long long)it->second.first) % (long long)q;
+                            long long db = ((long long)it->second.second - (long long)b) % (long long)q;
+                            if (da < 0) da += q;
+                            if (db < 0) db += q;
+                            u64 cand = (u64)mulMod(da, modInverse(db, (long long)q), (long long)q);
+                            if (mont.pow(g, cand) == h) {
+                                result = cand;
+                                found = true;
+                                stop = true;
+                            }
+                        }
+                        break;   // new start point after every distinguished point
+                    }
+                    if (len > ((u64)RHO_RESTART_FACTOR << dpBits)) break;   // stuck in a short cycle
+                    int j = (int)(hsh >> 59);
+                    X = mont.mul(X, M[j]);
+                    a += mu[j], b += mv[j];
+                    a -= a >= q ? q : 0, b -= b >= q ? q : 0;
+                    if (++local == 4096) {
+                        if ((total += local) > maxSteps) stop = true;
+                        local = 0;
+                    }
+                }
+            }
+            total += local;
+        }));
+    }
+    for (auto& f : workers) f.get();
+    if (steps) *steps += total;
+    if (found) x = result;
+    return found;
+}
+
+// Work done for one prime power q^e of the order of g
+struct DlogStep {
+    u64 q = 0;
+    int e = 0;
+    string method;     // "bsgs" or "rho"
+    u64 steps = 0;     // group operations of the searches (baby + giant steps, or walk steps)
+    double ms = 0;
+};
+
+struct DlogReport {
+    bool found = false;
+    bool gaveUp = false;   // h is in <g>, but a rho search hit its step limit
+    u64 x = 0;         // h = g^x with 0 <= x < order
+    u64 order = 0;     // order of g
+    vector<DlogStep> steps;
+    double ms = 0;     // whole Pohlig–Hellman run (the factorization of p - 1 is done by the group)
+};
+
+// log_g(h) in Z_p* by Pohlig–Hellman over the group's factorization of p - 1
+inline DlogReport discreteLog(const ElGamalGroup& group, long long g, long long h, ThreadPool& pool) {
+    auto start = chrono::steady_clock::now();
+    DlogReport rep;
+    u64 p = (u64)group.p;
+    Montgomery mont(p);
+    g %= group.p, h %= group.p;
+    if (g < 0) g += group.p;
+    if (h < 0) h += group.p;
+    if (g == 0 || h == 0) throw invalid_argument("discreteLog needs g and h in Z_p*");
+    u64 gm = mont.toMont((u64)g), hm = mont.toMont((u64)h);
+
+    // order of g: drop every prime factor it does not need
+    u64 order = p - 1;
+    vector<pair<u64, int>> factors;
+    for (size_t i = 0; i < group.primeFactors.size(); i++) {
+        u64 q = (u64)group.primeFactors[i];
+        int e = group.multiplicity[i];
+        while (e > 0 && mont.pow(gm, order / q) == mont.one) order /= q, e--;
+        if (e > 0) factors.push_back({q, e});
+    }
+    rep.order = order;
+    auto finish = [&] {
+        rep.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return rep;
+    };
+    if (mont.pow(hm, order) != mont.one) return finish();   // h is not in <g>
+
+    u64 x = 0, modulus = 1;   // x mod prod of the finished prime powers
+    for (auto [q, e] : factors) {
+        auto t0 = chrono::steady_clock::now();
+        DlogStep step;
+        step.q = q, step.e = e;
+        step.method = 64 - __builtin_clzll(q) <= DLOG_BSGS_MAX_BITS ? "bsgs" : "rho";
+        u64 qe = 1;
+        for (int i = 0; i < e; i++) qe *= q;
+        u64 cofactor = order / qe;
+        u64 gq = mont.pow(gm, cofactor), hq = mont.pow(hm, cofactor);   // order q^e subgroup
+        u64 gamma = mont.pow(gq, qe / q);                              // order q
+        // x mod q^e = d_0 + d_1 q + ... : peel one digit per round
+        u64 xq = 0, qk = 1;
+        bool ok = true;
+        for (int k = 0; k < e && ok; k++) {
+            u64 rest = mont.mul(hq, montInverse(mont, mont.pow(gq, xq)));   // g_q^(x - xq)
+            u64 target = mont.pow(rest, qe / q / qk);
+            u64 d = 0;
+            ok = step.method == "bsgs" ? bsgs(mont, gamma, target, q, d, &step.steps)
+                                       : pollardRho(mont, gamma, target, q, pool, d, &step.steps);
+            xq += d * qk;
+            qk *= q;
+        }
+        step.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        rep.steps.push_back(step);
+        if (!ok) {
+            rep.gaveUp = true;   // h^order == 1 was checked above, so an x does exist
+            return finish();
+        }
+        // CRT: x' == x (mod modulus), x' == xq (mod qe)
+        long long t = ((long long)(xq % qe) - (long long)(x % qe)) % (long long)qe;
+        if (t < 0) t += qe;
+        t = mulMod(t, modInverse((long long)(modulus % qe), (long long)qe), (long long)qe);
+        x += modulus * (u64)t;
+        modulus *= qe;
+    }
+    rep.found = mont.pow(gm, x) == hm;
+    rep.x = x;
+    return finish();
+}
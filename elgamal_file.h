@@ -0,0 +1,193 @@
+/*
+    elgamal_file.h — ElGamal key files and the binary ciphertext file
+
+    Purpose:
+    - Elgamal_batch.cpp encrypts streams of messages into a file that decryption
+        (and any later pass over the ciphertexts) maps into memory and reads in
+        place: fixed-width records, no text to parse, so every worker can jump
+        straight to its share of the records.
+
+    Key file ("name value" lines, '#' comments, like the RSA key files):
+        p <prime, below 2^62>
+        g <generator>
+        h <public key g^x>
+        x <private key>        only in the private key file
+    - loadElGamalKey checks that p is an odd prime below 2^62, g and h are in
+        range, and h == g^x when x is present.
+
+    Ciphertext file (little-endian, 8-byte fields):
+        offset  0: magic "EGCT0001"
+        offset  8: p, g, h         the public key the records were made under
+        offset 32: count           number of records
+        offset 40: 24 reserved bytes (zero), so records start 64-byte aligned
+        offset 64: count records of { c1, c2 } (16 bytes each)
+    - A record with c1 = 0 marks a message that could not be encrypted (g^k is
+        never 0), so the records stay lined up with the input.
+    - CipherFileReader maps the file and hands out the records as a plain array
+        (the layout is the in-memory layout of CipherRecord on a little-endian CPU).
+    - CipherFileWriter appends records with write() and fills in `count` when it is
+        closed, so the number of messages does not need to be known up front.
+*/
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "modint.h"
+#include "primes.h"
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the ciphertext file is mapped in place: little-endian only");
+
+const int ELGAMAL_MAX_P_BITS = 62;   // the long long demos keep every intermediate below 2^63
+
+struct ElGamalKey {
+    long long p = 0, g = 0, h = 0;
+    long long x = -1;   // private key, -1 in a public key file
+
+    bool hasPrivate() const { return x >= 0; }
+};
+
+inline void writeElGamalKey(ostream& out, const ElGamalKey& key, bool withPrivate) {
+    out << "# ElGamal " << (withPrivate ? "private" : "public") << " key, " << 64 - __builtin_clzll(key.p) << "-bit p\n";
+    out << "p " << key.p << "\ng " << key.g << "\nh " << key.h << "\n";
+    if (withPrivate) out << "x " << key.x << "\n";
+}
+
+inline bool loadElGamalKey(const string& path, ElGamalKey& key) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "cannot open key file " << path << "\n";
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string name;
+        long long value;
+        if (!(fields >> name) || name[0] == '#' || !(fields >> value)) continue;
+        if (name == "p") key.p = value;
+        else if (name == "g") key.g = value;
+        else if (name == "h") key.h = value;
+        else if (name == "x") key.x = value;
+    }
+    string problem;
+    if (key.p < 3 || key.p >= (1LL << ELGAMAL_MAX_P_BITS) || !isPrime((u64)key.p)) problem = "p must be an odd prime below 2^62";
+    else if (key.g < 2 || key.g >= key.p || key.h < 1 || key.h >= key.p) problem = "g and h must be in [2, p) and [1, p)";
+    else if (key.hasPrivate() && power(key.g, key.x, key.p) != key.h) problem = "h != g^x mod p";
+    if (!problem.empty()) {
+        cerr << path << ": " << problem << "\n";
+        return false;
+    }
+    return true;
+}
+
+const char CIPHER_FILE_MAGIC[8] = {'E', 'G', 'C', 'T', '0', '0', '0', '1'};
+
+struct CipherFileHeader {
+    char magic[8];
+    u64 p, g, h;
+    u64 count;
+    u64 reserved[3];
+};
+static_assert(sizeof(CipherFileHeader) == 64, "CipherFileHeader must stay 64 bytes");
+
+struct CipherRecord {
+    u64 c1, c2;
+};
+static_assert(sizeof(CipherRecord) == 16, "CipherRecord must stay 16 bytes");
+
+class CipherFileWriter {
+public:
+    ~CipherFileWriter() { close(); }
+
+    bool open(const string& path, const ElGamalKey& key) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        header = CipherFileHeader{};
+        memcpy(header.magic, CIPHER_FILE_MAGIC, 8);
+        header.p = key.p, header.g = key.g, header.h = key.h;
+        return writeAll(&header, sizeof header);
+    }
+
+    bool append(const CipherRecord* records, size_t n) {
+        header.count += n;
+        return writeAll(records, n * sizeof(CipherRecord));
+    }
+
+    // Writes the final record count into the header; false if any write failed
+    bool close() {
+        if (fd < 0) return ok;
+        ok = ok && pwrite(fd, &header.count, sizeof header.count, offsetof(CipherFileHeader, count)) == sizeof header.count;
+        ok = ::close(fd) == 0 && ok;
+        fd = -1;
+        return ok;
+    }
+
+    u64 count() const { return header.count; }
+
+private:
+    int fd = -1;
+    bool ok = true;
+    CipherFileHeader header{};
+
+    bool writeAll(const void* data, size_t len) {
+        const char* p = (const char*)data;
+        while (ok && len > 0) {
+            ssize_t put = write(fd, p, len);
+            if (put < 0 && errno == EINTR) continue;
+            if (put <= 0) ok = false;
+            else p += put, len -= put;
+        }
+        return ok;
+    }
+};
+
+class CipherFileReader {
+public:
+    CipherFileReader() {}
+    CipherFileReader(const CipherFileReader&) = delete;
+    CipherFileReader& operator=(const CipherFileReader&) = delete;
+    ~CipherFileReader() {
+        if (map) munmap(map, size);
+    }
+
+    // Maps the file and checks the header; prints the reason and returns false when it is unusable
+    bool open(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            cerr << "cannot open ciphertext file " << path << "\n";
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        size = st.st_size;
+        void* m = size >= sizeof(CipherFileHeader) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (m == MAP_FAILED) {
+            cerr << path << ": not a ciphertext file\n";
+            return false;
+        }
+        map = m;
+        madvise(map, size, MADV_SEQUENTIAL);
+        const CipherFileHeader& h = header();
+        if (memcmp(h.magic, CIPHER_FILE_MAGIC, 8) != 0) {
+            cerr << path << ": not a ciphertext file (bad magic)\n";
+            return false;
+        }
+        if (h.count > (size - sizeof(CipherFileHeader)) / sizeof(CipherRecord)) {
+            cerr << path << ": header says " << h.count << " records but the file is shorter\n";
+            return false;
+        }
+        return true;
+    }
+
+    const CipherFileHeader& header() const { return *(const CipherFileHeader*)map; }
+    const CipherRecord* records() const { return (const CipherRecord*)((const char*)map + sizeof(CipherFileHeader)); }
+    u64 count() const { return header().count; }
+
+private:
+    void* map = nullptr;
+    size_t size = 0;
+};
@@ -0,0 +1,91 @@
+/*
+    elgamal_group.h — the group Z_p* of an ElGamal prime, with p - 1 factored once
+
+    Purpose:
+    - g generates Z_p* exactly when g^((p-1)/q) != 1 for every prime q dividing
+        p - 1. The demos used to re-factor p - 1 by trial division for every
+        candidate g, which is hopeless beyond ~40-bit p. ElGamalGroup factors
+        p - 1 once (factor.h: wheel trial division, then Pollard-Brent rho for
+        the cofactor) and keeps the exponents (p-1)/q, so each generator test is
+        a handful of Montgomery exponentiations.
+
+    Contents:
+    - ElGamalGroup(p, pool): checks p, factors p - 1, builds the Montgomery context;
+        the factorization stays public (primeFactors / multiplicity) for
+        Pohlig–Hellman (elgamal_dlog.h)
+    - isGenerator(g): one exponentiation per distinct prime factor of p - 1
+    - findGenerator(from, pool): the smallest generator >= from; the workers
+        claim blocks of GENERATOR_BLOCK candidates in increasing order and stop
+        once a lower block has produced a hit, so the answer is the same as the
+        sequential scan
+
+    Notes:
+    - p must be an odd prime below 2^63 (the 64-bit Montgomery limit).
+    - A fraction phi(p-1)/(p-1) of all candidates are generators, at least ~14%
+        for p < 2^63, so the search nearly always ends within the first block.
+*/
+
+#pragma once
+
+#include "factor.h"
+
+const int GENERATOR_BLOCK = 16;   // candidates per claimed block in findGenerator
+
+class ElGamalGroup {
+public:
+    long long p;
+    vector<long long> primeFactors;   // distinct primes q dividing p - 1, ascending
+    vector<int> multiplicity;         // exponent of each primeFactors[i] in p - 1
+
+    ElGamalGroup(long long p, ThreadPool& pool) : p(p), mont(p < 3 ? 3 : (u64)p) {
+        if (p < 3 || !(p & 1) || !isPrime((u64)p)) throw invalid_argument(to_string(p) + " is not an odd prime");
+        FactorStats stats;
+        for (const BigInt& q : factorize(BigInt(p - 1), pool, &stats)) {
+            long long v = (long long)q.low();
+            if (primeFactors.empty() || primeFactors.back() != v) primeFactors.push_back(v), multiplicity.push_back(0);
+            multiplicity.back()++;
+        }
+        if (!stats.unfactored.empty()) throw runtime_error("could not factor p - 1");
+        for (long long q : primeFactors) exponents.push_back((u64)((p - 1) / q));
+    }
+
+    // Whether g generates Z_p* (g is reduced mod p first)
+    bool isGenerator(long long g) const {
+        g %= p;
+        if (g < 0) g += p;
+        if (g == 0) return false;
+        u64 gm = mont.toMont((u64)g);
+        for (u64 e : exponents)
+            if (mont.pow(gm, e) == mont.one) return false;
+        return true;
+    }
+
+    // Smallest generator in [from, p), or 0 if there is none
+    long long findGenerator(long long from, ThreadPool& pool) const {
+        from = max(from, 1LL);
+        atomic<long long> nextBlock(0), best(LLONG_MAX);
+        vector<future<void>> workers;
+        for (unsigned w = 0; w < pool.size(); w++) {
+            workers.push_back(pool.submit([&] {
+                while (true) {
+                    long long lo = from + nextBlock++ * GENERATOR_BLOCK;
+                    if (lo >= p || lo >= best) return;   // every lower block is already claimed
+                    for (long long g = lo; g < min(lo + GENERATOR_BLOCK, p); g++) {
+                        if (!isGenerator(g)) continue;
+                        long long cur = best;
+                        while (g < cur && !best.compare_exchange_weak(cur, g)) {
+                        }
+                        return;
+                    }
+                }
+            }));
+        }
+        for (auto& f : workers) f.get();
+        long long g = best;
+        return g == LLONG_MAX ? 0 : g;
+    }
+
+private:
+    Montgomery mont;
+    vector<u64> exponents;   // (p - 1) / q for each q in primeFactors
+};
@@ -0,0 +1,253 @@
+/*
+    elgamal_params.h — ElGamal domain parameters (p, q, g): generation, save and load
+
+    Purpose:
+    - The demos ask for p and then search for a generator, which needs p - 1
+        factored. Choosing p with a known structure makes the generator free:
+        safe primes: p = 2q + 1 with q prime. The only subgroup orders are
+            1, 2, q and 2q, so g generates all of Z_p* exactly when
+            g^q == p - 1 (one exponentiation per candidate, no factoring).
+        Schnorr groups: p = k*q + 1 with a prime q of chosen size (e.g. 256
+            bits inside a 2048-bit p). g = h^((p-1)/q) != 1 has order q.
+    - Parameters are written to a small text file, so a service loads them at
+        start-up instead of searching again.
+
+    How the search works (same shape as randomPrime in primes.h):
+    - Every worker of the ThreadPool sieves its own random window of SIEVE_WINDOW
+        candidates with the odd primes below SIEVE_LIMIT; the first hit wins
+        (raceWorkers).
+    - Safe primes: a candidate q is crossed off when r | q or r | 2q + 1, so about
+        99% of the window dies without any exponentiation. Survivors go through
+        base-2 Miller–Rabin on q, a base-2 Fermat test on p, then BPSW on q.
+        Once q is prime, 2^(p-1) == 1 (mod p) proves p prime (Pocklington:
+        the only other condition, gcd(2^2 - 1, p) = 1, is guaranteed by the sieve).
+    - Schnorr groups: each worker draws its own q (searchPrime), then sieves
+        windows of even multipliers k (p = k*q + 1 with exactly pBits bits) and
+        runs BPSW on the survivors.
+
+    File format ("name value" lines, '#' comments, like the RSA key files):
+        kind safe|schnorr
+        p <modulus>
+        q <prime order>
+        g <generator>
+    - For kind safe, g generates Z_p* (order 2q); for schnorr, g has order q.
+    - loadElGamalParams re-checks everything (BPSW on p and q, q | p - 1, the
+        order of g): about 0.1 s for a 2048-bit safe prime, against ~20 s to
+        generate one on a single core.
+*/
+
+#pragma once
+
+#include "primes.h"
+
+struct ElGamalParams {
+    BigInt p, q, g;
+    bool safe = true;   // p = 2q + 1 and g generates Z_p*; otherwise g generates the order-q subgroup
+};
+
+const int SCHNORR_WINDOWS = 8;   // k windows tried for one q before a Schnorr worker draws a new q
+
+// Offsets i (q = start + 2i) where neither q nor 2q + 1 has an odd prime factor below
+// SIEVE_LIMIT. start must be odd and larger than SIEVE_LIMIT.
+inline vector<int> safePrimeSieveWindow(const BigInt& start) {
+    vector<char> composite(SIEVE_WINDOW, 0);
+    for (u64 r : sievePrimes()) {
+        u64 s = start.modU64(r), half = (r + 1) / 2;   // half = 2^-1 mod r
+        u64 i = (r - s) % r * half % r;                             // r | q
+        for (; i < (u64)SIEVE_WINDOW; i += r) composite[i] = 1;
+        i = ((r - 1) / 2 + r - s) % r * half % r;                   // r | 2q + 1  <=>  q == (r - 1) / 2
+        for (; i < (u64)SIEVE_WINDOW; i += r) composite[i] = 1;
+    }
+    vector<int> survivors;
+    for (int i = 0; i < SIEVE_WINDOW; i++)
+        if (!composite[i]) survivors.push_back(i);
+    return survivors;
+}
+
+// Searches for a safe prime p = 2q + 1 with exactly `bits` bits; q is stored in `q`.
+// Returns false when `stop` became true first. One worker's share of generateSafePrimeParams.
+template <class RNG>
+bool searchSafePrime(int bits, RNG& rng, const atomic<bool>& stop, BigInt& q) {
+    auto draw = [&] {
+        BigInt q = randomBits(bits - 1, rng);
+        if (!q.bit(bits - 2)) q += BigInt(1) << (bits - 2);
+        return q.isOdd() ? q : q + 1;
+    };
+    if (bits <= 40) {
+        while (!stop) {
+            q = draw();
+            if (q.bitLength() == bits - 1 && isPrime(q.low()) && isPrime(2 * q.low() + 1)) return true;
+        }
+        return false;
+    }
+    while (!stop) {
+        BigInt start = draw();
+        for (int i : safePrimeSieveWindow(start)) {
+            if (stop) break;
+            q = start + BigInt(2LL * i);
+            if (q.bitLength() != bits - 1) break;
+            BigInt p = 2 * q + 1;
+            if (!isProbablePrime(q, 1)) continue;
+            if (power(BigInt(2), p - 1, p) != BigInt(1)) continue;
+            if (isProbablePrimeBPSW(q)) return true;
+        }
+    }
+    return false;
+}
+
+// Offsets i (k = k0 + 2i) where p = k*q + 1 has no odd prime factor below SIEVE_LIMIT
+inline vector<int> schnorrSieveWindow(const BigInt& k0, const BigInt& q) {
+    vector<char> composite(SIEVE_WINDOW, 0);
+    BigInt p0 = k0 * q + 1;
+    for (u64 r : sievePrimes()) {
+        u64 q2 = 2 * q.modU64(r) % r;   // p grows by 2q per step
+        if (q2 == 0) continue;           // r | q: p == 1 (mod r) for every k
+        u64 i = (r - p0.modU64(r)) % r * (u64)modInverse((long long)q2, (long long)r) % r;
+        for (; i < (u64)SIEVE_WINDOW; i += r) composite[i] = 1;
+    }
+    vector<int> survivors;
+    for (int i = 0; i < SIEVE_WINDOW; i++)
+        if (!composite[i]) survivors.push_back(i);
+    return survivors;
+}
+
+// Searches for a Schnorr group: a random qBits-bit prime q, then p = k*q + 1 (k even) with
+// exactly pBits bits. After SCHNORR_WINDOWS fruitless windows of k it starts over with a new
+// q, so a narrow k range (pBits close to qBits) cannot stall it. One worker's share of
+// generateSchnorrParams; returns false when `stop` became true first.
+template <class RNG>
+bool searchSchnorrGroup(int pBits, int qBits, RNG& rng, const atomic<bool>& stop, ElGamalParams& out) {
+    while (!stop) {
+        BigInt q = searchPrime(qBits, rng, stop);
+        if (q.isZero()) break;
+        BigInt kMin = ((BigInt(1) << (pBits - 1)) + q - 1) / q;   // smallest k giving pBits bits
+        BigInt kSpan = ((BigInt(1) << pBits) - 1) / q - kMin;      // k in [kMin, kMin + kSpan]
+        for (int window = 0; window < SCHNORR_WINDOWS && !stop; window++) {
+            BigInt k0 = kMin + randomBelow(kSpan + 1, rng);
+            if (k0.isOdd()) k0 += 1;
+            vector<int> survivors;
+            if (pBits > 62) survivors = schnorrSieveWindow(k0, q);
+            else for (int i = 0; i < SIEVE_WINDOW; i++) survivors.push_back(i);
+            for (int i : survivors) {
+                if (stop) break;
+                BigInt p = (k0 + BigInt(2LL * i)) * q + 1;
+                if (p.bitLength() != pBits) break;
+                if (pBits <= 62 ? isPrime(p.low()) : isProbablePrimeBPSW(p)) {
+                    out.p = p;
+                    out.q = q;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Whether any Schnorr group with a pBits-bit p and a qBits-bit q can be found, checked by
+// walking every q that searchPrime can draw (top two bits set) and every even k. Only used
+// for pBits <= 32: at tiny sizes the k range can be a single value whose k*q + 1 are all
+// composite (pBits = 8, qBits = 6 leaves q in {53, 59, 61} and k = 4), and the random
+// search would never stop. Stops at the first group found, so possible sizes cost little.
+inline bool schnorrGroupExists(int pBits, int qBits) {
+    u64 qLo = qBits > 3 ? 3ULL << (qBits - 2) : 1ULL << (qBits - 1), qHi = 1ULL << qBits;
+    u64 pLo = 1ULL << (pBits - 1), pHi = 1ULL << pBits;
+    for (u64 q = qLo | 1; q < qHi; q += 2) {
+        if (!isPrime(q)) continue;
+        u64 k = (pLo + q - 1) / q;   // smallest k with k*q + 1 >= 2^(pBits-1)
+        for (k += k & 1; k * q + 1 < pHi; k += 2)
+            if (isPrime(k * q + 1)) return true;
+    }
+    return false;
+}
+
+// g generating Z_p* for a safe prime p = 2q + 1: the smallest g >= 2 with g^q == p - 1
+inline BigInt safePrimeGenerator(const BigInt& p, const BigInt& q) {
+    for (BigInt g = 2;; g += 1)
+        if (g != p - 1 && power(g, q, p) == p - 1) return g;
+}
+
+// g of order q: h^((p-1)/q) for the smallest h >= 2 that does not give 1
+inline BigInt schnorrGenerator(const BigInt& p, const BigInt& q) {
+    BigInt e = (p - 1) / q;
+    for (BigInt h = 2;; h += 1) {
+        BigInt g = power(h, e, p);
+        if (g != BigInt(1)) return g;
+    }
+}
+
+// Safe-prime group with a `bits`-bit p (bits >= 6), searched on every worker of the pool
+inline ElGamalParams generateSafePrimeParams(int bits, ThreadPool& pool) {
+    if (bits < 6) throw invalid_argument("safe primes need at least 6 bits");
+    ElGamalParams params;
+    params.q = raceWorkers<BigInt>(pool, [bits](mt19937_64& rng, const atomic<bool>& stop, BigInt& q) {
+        return searchSafePrime(bits, rng, stop, q);
+    });
+    params.p = 2 * params.q + 1;
+    params.g = safePrimeGenerator(params.p, params.q);
+    params.safe = true;
+    return params;
+}
+
+// Schnorr group: pBits-bit p with a qBits-bit prime q dividing p - 1 (qBits >= 3, qBits + 2 <= pBits)
+inline ElGamalParams generateSchnorrParams(int pBits, int qBits, ThreadPool& pool) {
+    if (qBits < 3 || qBits + 2 > pBits) throw invalid_argument("Schnorr groups need 3 <= qBits <= pBits - 2");
+    if (pBits <= 32 && !schnorrGroupExists(pBits, qBits))
+        throw invalid_argument("no Schnorr group with a " + to_string(pBits) + "-bit p and a "
+                               + to_string(qBits) + "-bit q exists");
+    ElGamalParams params = raceWorkers<ElGamalParams>(pool, [=](mt19937_64& rng, const atomic<bool>& stop, ElGamalParams& out) {
+        return searchSchnorrGroup(pBits, qBits, rng, stop, out);
+    });
+    params.g = schnorrGenerator(params.p, params.q);
+    params.safe = false;
+    return params;
+}
+
+inline void writeElGamalParams(ostream& out, const ElGamalParams& params) {
+    out << "# ElGamal parameters, " << params.p.bitLength() << "-bit p, " << params.q.bitLength() << "-bit q\n";
+    out << "kind " << (params.safe ? "safe" : "schnorr") << "\n";
+    out << "p " << params.p << "\nq " << params.q << "\ng " << params.g << "\n";
+}
+
+// Reads and re-validates a parameter file; prints the reason and returns false when it is unusable
+inline bool loadElGamalParams(const string& path, ElGamalParams& params) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "cannot open parameter file " << path << "\n";
+        return false;
+    }
+    string line, kind;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string name, value;
+        if (!(fields >> name >> value) || name[0] == '#') continue;
+        if (name == "kind") {
+            kind = value;
+            continue;
+        }
+        BigInt v;
+        try {
+            v = BigInt::fromString(value);
+        } catch (const invalid_argument&) {
+            cerr << "bad number for " << name << " in " << path << "\n";
+            return false;
+        }
+        if (name == "p") params.p = v;
+        else if (name == "q") params.q = v;
+        else if (name == "g") params.g = v;
+    }
+    params.safe = kind != "schnorr";
+    const BigInt& p = params.p;
+    const BigInt& q = params.q;
+    const BigInt& g = params.g;
+    string problem;
+    if (kind != "safe" && kind != "schnorr") problem = "kind must be safe or schnorr";
+    else if (p < BigInt(7) || q < BigInt(3) || g < BigInt(2) || g >= p - 1) problem = "p, q and g are missing or out of range";
+    else if (params.safe ? p != 2 * q + 1 : !((p - 1) % q).isZero()) problem = params.safe ? "p != 2q + 1" : "q does not divide p - 1";
+    else if (!isProbablePrimeBPSW(p) || !isProbablePrimeBPSW(q)) problem = "p or q is not prime";
+    else if (params.safe ? power(g, q, p) != p - 1 : power(g, q, p) != BigInt(1)) problem = "g does not have the expected order";
+    if (!problem.empty()) {
+        cerr << path << ": " << problem << "\n";
+        return false;
+    }
+    return true;
+}
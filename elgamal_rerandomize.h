@@ -0,0 +1,89 @@
+/*
+    elgamal_rerandomize.h — offline/online ElGamal rerandomization
+
+    Purpose:
+    - Rerandomizing (c1, c2) multiplies it by a fresh encryption of 1,
+        (g^k, h^k): the plaintext is unchanged, the ciphertext is unlinkable to
+        the old one. Computing g^k and h^k inline costs two exponentiations per
+        ciphertext, although neither depends on the ciphertext.
+    - RerandomizationPool computes the pairs ahead of time on background threads
+        (offline phase). The online phase, rerandomize() or a mix-net shuffle,
+        then costs two modular multiplications per ciphertext.
+
+    Refill policy (RefillPool, refill_pool.h, shared with RSAKeyPool):
+    - A take that leaves `lowWater` pairs or fewer starts a refill round. Pairs
+        are cheap, so a producer reserves REFILL_BLOCK slots per lock instead of one,
+        and rerandomize() takes them REFILL_BLOCK at a time.
+    - waitUntilFull() runs a round on demand and blocks until it completes, for
+        callers that have idle time between online batches (the offline phase).
+    - A take from an empty pool computes its pair inline, so the pool only changes
+        the speed, never the result.
+    - stats(): depth, hits / misses, refill rounds and refill latency (RefillStats).
+
+    Notes:
+    - The pairs are kept in Montgomery form, so multiplying a plain residue by one
+        of them gives a plain residue with a single REDC.
+    - Same non-cryptographic RNG caveat as primes.h.
+*/
+
+#pragma once
+
+#include "elgamal_file.h"
+#include "refill_pool.h"
+
+const size_t REFILL_BLOCK = 256;   // pairs a producer generates per reservation, and taken per online step
+
+// One encryption of 1 (g^k, h^k), both in Montgomery form
+struct EncryptionOfOne {
+    u64 gk = 0, hk = 0;
+};
+
+class RerandomizationPool {
+public:
+    RerandomizationPool(const ElGamalKey& key, size_t capacity = 1 << 16, size_t lowWater = 1 << 14, unsigned threads = 1)
+        : p(key.p), mont((u64)key.p), gm(mont.toMont((u64)key.g)), hm(mont.toMont((u64)key.h)),
+          pool([this](mt19937_64& rng) { return makePair(rng); }, capacity, lowWater, threads, REFILL_BLOCK) {}
+
+    // A fresh pair: from the queue when one is ready, computed on this thread otherwise
+    EncryptionOfOne take() { return pool.take(); }
+
+    // Online phase: cts[i] *= (g^k_i, h^k_i) with a fresh pair each; values must be below p
+    void rerandomize(CipherRecord* cts, size_t n) {
+        EncryptionOfOne pairs[REFILL_BLOCK];
+        for (size_t lo = 0; lo < n; lo += REFILL_BLOCK) {
+            size_t len = min(REFILL_BLOCK, n - lo);
+            pool.take(pairs, len);
+            for (size_t i = 0; i < len; i++) {
+                CipherRecord& r = cts[lo + i];
+                r.c1 = mont.mul(r.c1, pairs[i].gk);   // plain * Montgomery form = plain
+                r.c2 = mont.mul(r.c2, pairs[i].hk);
+            }
+        }
+    }
+
+    // Mix-net step: random permutation (Fisher–Yates), then rerandomization of every entry
+    template <class RNG>
+    void shuffle(vector<CipherRecord>& cts, RNG& rng) {
+        for (size_t i = cts.size(); i > 1; i--) swap(cts[i - 1], cts[rng() % i]);
+        rerandomize(cts.data(), cts.size());
+    }
+
+    // Offline phase on demand: tops the pool up to capacity and blocks until it is full
+    void waitUntilFull() { pool.waitUntilFull(); }
+
+    size_t available() const { return pool.available(); }
+    size_t capacity() const { return pool.capacity(); }
+    RefillStats stats() const { return pool.stats(); }
+
+private:
+    long long p;
+    Montgomery mont;
+    u64 gm, hm;   // g and h in Montgomery form
+    RefillPool<EncryptionOfOne> pool;   // last: its producers use mont, gm and hm
+
+    template <class RNG>
+    EncryptionOfOne makePair(RNG& rng) const {
+        u64 k = 1 + rng() % (u64)(p - 2);
+        return EncryptionOfOne{mont.pow(gm, k), mont.pow(hm, k)};
+    }
+};
@@ -0,0 +1,99 @@
+/*
+    elgamal_tally.h — product of many ElGamal ciphertexts (homomorphic tally)
+
+    Purpose:
+    - ElGamal is multiplicatively homomorphic: (c1, c2) * (c1', c2') componentwise
+        decrypts to m * m'. Multiplying every ballot of an election gives one
+        ciphertext of the product of all plaintexts; with votes encrypted as g^v
+        (exponential ElGamal) that product is g^(number of yes votes), and only
+        this one aggregate is ever decrypted.
+
+    Layout and reduction:
+    - CiphertextSoA keeps all c1 values in one array and all c2 values in another,
+        so the reduction streams two dense arrays (loadCiphertexts transposes the
+        16-byte records of a ciphertext file, elgamal_file.h, in parallel).
+    - aggregateCiphertexts cuts the arrays into TALLY_CHUNKS_PER_THREAD chunks per
+        worker. A chunk's partial product goes into its own cache-line-sized slot,
+        so the workers share nothing while they run; the partials are then combined
+        pairwise, level by level (a binary tree), in a fixed order.
+    - Within a chunk, four independent accumulators per component hide the
+        multiplication latency, and the values are multiplied in as plain
+        residues: each Montgomery product then divides by R once more, and a
+        single correction by R^count at the end of the chunk puts that right.
+        That is one REDC per ciphertext component, with no conversion to
+        Montgomery form.
+*/
+
+#pragma once
+
+#include "elgamal_file.h"
+#include "thread_pool.h"
+
+const int TALLY_CHUNKS_PER_THREAD = 4;   // chunks per worker (some slack for uneven scheduling)
+
+struct CiphertextSoA {
+    vector<u64> c1, c2;
+
+    size_t size() const { return c1.size(); }
+};
+
+// Copies records into SoA form in parallel. Error records (c1 = 0) and values that are not
+// below p become (1, 1), an encryption of 1 that leaves the product unchanged; their number
+// is returned in `invalid`.
+inline CiphertextSoA loadCiphertexts(const CipherRecord* records, size_t count, u64 p, ThreadPool& pool, size_t& invalid) {
+    CiphertextSoA soa;
+    soa.c1.resize(count);
+    soa.c2.resize(count);
+    size_t chunks = (size_t)pool.size() * TALLY_CHUNKS_PER_THREAD;
+    atomic<size_t> bad(0);
+    parallelFor(pool, (long long)chunks, [&](long long c) {
+        size_t lo = count * c / chunks, hi = count * (c + 1) / chunks, localBad = 0;
+        for (size_t i = lo; i < hi; i++) {
+            bool ok = records[i].c1 != 0 && records[i].c1 < p && records[i].c2 < p;
+            soa.c1[i] = ok ? records[i].c1 : 1;
+            soa.c2[i] = ok ? records[i].c2 : 1;
+            localBad += !ok;
+        }
+        bad += localBad;
+    });
+    invalid = bad;
+    return soa;
+}
+
+// prod xs[0..n) mod p in Montgomery form; xs are plain residues below p
+inline u64 productMont(const Montgomery& mont, const u64* xs, size_t n) {
+    u64 acc[4] = {mont.one, mont.one, mont.one, mont.one};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        for (int j = 0; j < 4; j++) acc[j] = mont.mul(acc[j], xs[i + j]);
+    for (; i < n; i++) acc[0] = mont.mul(acc[0], xs[i]);
+    // The accumulators start at R (1 in Montgomery form); each product above and each of the
+    // three merges below divides by R once, leaving P * R^(4-n-3) = P * R^(1-n). The Montgomery
+    // form P * R is one more product with raw R^(n+1), i.e. R^n in Montgomery form.
+    u64 res = mont.mul(mont.mul(acc[0], acc[1]), mont.mul(acc[2], acc[3]));
+    return mont.mul(res, mont.pow(mont.r2, n));   // r2 is R in Montgomery form
+}
+
+// Componentwise product of n ciphertexts (plain residues below p, p odd), as a plain record
+inline CipherRecord aggregateCiphertexts(const Montgomery& mont, const u64* c1, const u64* c2, size_t n, ThreadPool& pool) {
+    struct alignas(64) Partial {
+        u64 c1, c2;
+    };
+    size_t chunks = max<size_t>(1, min(n, (size_t)pool.size() * TALLY_CHUNKS_PER_THREAD));
+    vector<Partial> partial(chunks);
+    parallelFor(pool, (long long)chunks, [&](long long c) {
+        size_t lo = n * c / chunks, hi = n * (c + 1) / chunks;
+        partial[c].c1 = productMont(mont, c1 + lo, hi - lo);
+        partial[c].c2 = productMont(mont, c2 + lo, hi - lo);
+    });
+    for (size_t stride = 1; stride < chunks; stride *= 2)
+        for (size_t i = 0; i + stride < chunks; i += 2 * stride) {
+            partial[i].c1 = mont.mul(partial[i].c1, partial[i + stride].c1);
+            partial[i].c2 = mont.mul(partial[i].c2, partial[i + stride].c2);
+        }
+    return CipherRecord{mont.fromMont(partial[0].c1), mont.fromMont(partial[0].c2)};
+}
+
+inline CipherRecord aggregateCiphertexts(const Montgomery& mont, const CiphertextSoA& cts, ThreadPool& pool) {
+    return aggregateCiphertexts(mont, cts.c1.data(), cts.c2.data(), cts.size(), pool);
+}
@@ -0,0 +1,269 @@
+/*
+    elgamal_verify.h — faster ElGamal signature verification under one public key
+
+    Purpose:
+    - A signature (r, s) on M is valid when g^M == y^r * r^s (mod p). Checked
+        naively that is three full exponentiations per signature.
+
+    Single signatures (Shamir's trick / Straus):
+    - y^r * r^s is one interleaved exponentiation: a 16-entry table of
+        y^i * r^j (0 <= i, j < 4) and one pass over both exponents two bits at a
+        time, so the squarings are shared: about bits squarings + bits/2
+        multiplications, against 2 * bits squarings for two separate powers.
+
+    Batches (randomized linear combination):
+    - For random d_i, uniform in [1, 2^62), every valid batch satisfies
+            g^(sum d_i*M_i) == y^(sum d_i*r_i) * prod r_i^(d_i*s_i)    (exponents mod p-1)
+        which is checked as one multi-exponentiation equal to 1,
+            prod r_i^(d_i*s_i mod p-1) * y^(sum d_i*r_i) * g^(-sum d_i*M_i) == 1,
+        with Pippenger's buckets (multiPow64): a few multiplications per signature
+        instead of three exponentiations.
+    - A bad signature's error u = y^r * r^s / g^M gets through one such test with
+        probability about 1 / ord(u). Z_p* has elements of every order dividing
+        p - 1, which is even: adding (p-1)/2 to s when r is a non-residue makes
+        u = -1, and two such signatures pass with probability 1/2 per test.
+    - So a screen has two parts. First screenBits random-subset tests of the
+        same equation under the Legendre symbol (one Jacobi symbol per subset):
+        a signature with a non-residue error fails each with probability 1/2.
+        The errors left are squares, of order at least l, the smallest prime
+        factor of (p-1)/2, so the product test is repeated until
+        (1/l)^rounds < 2^-screenBits: once for a safe prime p = 2q + 1, 21 times
+        for l = 3. Either way a bad batch passes below 2^-screenBits.
+    - When that takes more than ELGAMAL_MAX_ROUNDS product tests the screen is
+        slower than verify() on every signature, so verifyBatch does that instead.
+    - A failing batch is bisected with the RSA batch verifier's bisectFailures
+        (rsa_batch_verify.h); ranges of ELGAMAL_VERIFY_LEAF or fewer are checked
+        one signature at a time.
+
+    Notes:
+    - verifyBatch(..., pool) cuts the batch into one part per worker and screens
+        and bisects the parts in parallel (bisectFailures on a ThreadPool): one
+        extra screen per part, so a clean batch costs `parts` screens.
+    - p must be an odd prime below 2^63 (64-bit Montgomery).
+    - A batch pass says the batch is valid except with probability below
+        2^-screenBits, not that each signature was checked individually.
+    - d_i come from std::mt19937_64 seeded from std::random_device (demo grade).
+*/
+
+#pragma once
+
+#include "rsa_batch_verify.h"
+#include "primes.h"
+
+const size_t ELGAMAL_VERIFY_LEAF = 8;      // ranges this small are verified one signature at a time
+const int ELGAMAL_MAX_ROUNDS = 12;         // a screen with more product tests is slower than one-by-one checks
+const size_t ELGAMAL_VERIFY_CHUNK = 256;   // signatures per task when they are checked one by one
+
+// a^e1 * b^e2 with a, b and the result in Montgomery form (Straus, 2-bit joint windows)
+inline u64 shamirPow(const Montgomery& mont, u64 a, u64 e1, u64 b, u64 e2) {
+    u64 table[16];   // table[4i + j] = a^i * b^j
+    table[0] = mont.one;
+    table[4] = a, table[8] = mont.mul(a, a), table[12] = mont.mul(table[8], a);
+    table[1] = b, table[2] = mont.mul(b, b), table[3] = mont.mul(table[2], b);
+    for (int i = 4; i < 16; i += 4)
+        for (int j = 1; j < 4; j++) table[i + j] = mont.mul(table[i], table[j]);
+    int bits = 64 - __builtin_clzll(e1 | e2 | 1);
+    u64 acc = mont.one;
+    bool started = false;
+    for (int lo = (bits - 1) & ~1; lo >= 0; lo -= 2) {
+        if (started) {
+            acc = mont.mul(acc, acc);
+            acc = mont.mul(acc, acc);
+        }
+        u64 idx = ((e1 >> lo) & 3) << 2 | ((e2 >> lo) & 3);
+        if (!idx) continue;
+        acc = started ? mont.mul(acc, table[idx]) : table[idx];
+        started = true;
+    }
+    return acc;
+}
+
+// prod xs[i]^es[i] in Montgomery form, es[i] < 2^bits (Pippenger buckets, as multiPow in rsa_batch_verify.h)
+inline u64 multiPow64(const Montgomery& mont, const vector<u64>& xs, const vector<u64>& es, int bits) {
+    int w = pippengerWindow(xs.size(), bits);
+    u64 mask = (1ULL << w) - 1, acc = mont.one;
+    vector<u64> bucket(1 << w);
+    for (int lo = (bits - 1) / w * w; lo >= 0; lo -= w) {
+        for (int s = 0; s < w; s++) acc = mont.mul(acc, acc);
+        fill(bucket.begin(), bucket.end(), mont.one);
+        for (size_t i = 0; i < xs.size(); i++) {
+            u64 v = (es[i] >> lo) & mask;
+            if (v) bucket[v] = mont.mul(bucket[v], xs[i]);
+        }
+        // sum of v * bucket[v] (multiplicatively): running product from the top bucket down
+        u64 run = mont.one, total = mont.one;
+        for (u64 v = mask; v >= 1; v--) {
+            run = mont.mul(run, bucket[v]);
+            total = mont.mul(total, run);
+        }
+        acc = mont.mul(acc, total);
+    }
+    return acc;
+}
+
+class ElGamalVerifier {
+public:
+    ElGamalVerifier(long long p, long long g, long long y, int screenBits = 32)
+        : p(p), mont(p), screenBits(max(1, min(screenBits, 62))), rng(random_device{}()) {
+        if (p < 5 || !(p & 1)) throw invalid_argument("ElGamalVerifier needs an odd prime p");
+        gm = mont.toMont((u64)g);
+        ym = mont.toMont((u64)y);
+        chiG = jacobi((u64)g, (u64)p);
+        chiY = jacobi((u64)y, (u64)p);
+        // a round passes a bad batch with probability at most 1/l + 2^-61, l the smallest prime of (p-1)/2
+        double perRound = 1.0 / (double)smallestPrimeFactor(((u64)p - 1) / 2) + ldexp(1.0, -61);
+        rounds = max(1, (int)ceil(this->screenBits / -log2(perRound)));
+    }
+
+    // y^r * r^s mod p, one interleaved exponentiation
+    long long rightSide(long long r, long long s) const {
+        return (long long)mont.fromMont(shamirPow(mont, ym, (u64)r, mont.toMont((u64)r), (u64)s));
+    }
+
+    // g^M == y^r * r^s (mod p), with 1 <= r < p and 0 <= s < p - 1
+    bool verify(long long M, long long r, long long s) const {
+        if (!inRange(r, s)) return false;
+        M %= p - 1;
+        if (M < 0) M += p - 1;
+        return mont.fromMont(mont.pow(gm, (u64)M)) == (u64)rightSide(r, s);
+    }
+
+    // Product tests a screen repeats for this p (more than ELGAMAL_MAX_ROUNDS: signatures are checked one by one)
+    int screenRounds() const { return rounds; }
+
+    // Verifies every (M_i, r_i, s_i)
+    BatchVerifyResult verifyBatch(const vector<long long>& msgs, const vector<long long>& rs, const vector<long long>& ss) {
+        return run(msgs, rs, ss, nullptr);
+    }
+
+    // Same, with the screens and leaf checks spread over the pool (one part of the batch per worker)
+    BatchVerifyResult verifyBatch(const vector<long long>& msgs, const vector<long long>& rs, const vector<long long>& ss,
+                                  ThreadPool& pool) {
+        return run(msgs, rs, ss, &pool);
+    }
+
+private:
+    long long p;
+    Montgomery mont;
+    u64 gm, ym;         // g and y in Montgomery form
+    int chiG, chiY;     // Legendre symbols (g / p), (y / p)
+    int screenBits;
+    int rounds;         // product tests per screen
+    mt19937_64 rng;
+    const vector<long long>* msgs = nullptr;
+    const vector<long long>* rs = nullptr;
+    const vector<long long>* ss = nullptr;
+    vector<u64> rm;   // r_i in Montgomery form
+
+    // Smallest prime factor of m > 1, or a lower bound of SIEVE_LIMIT when it is larger than that
+    static u64 smallestPrimeFactor(u64 m) {
+        if (!(m & 1)) return 2;
+        for (u64 q : sievePrimes()) {
+            if (q * q > m) return m;
+            if (m % q == 0) return q;
+        }
+        return isPrime(m) ? m : SIEVE_LIMIT;
+    }
+
+    BatchVerifyResult run(const vector<long long>& msgs, const vector<long long>& rs, const vector<long long>& ss,
+                          ThreadPool* pool) {
+        if (msgs.size() != rs.size() || msgs.size() != ss.size()) throw invalid_argument("batch verify needs one (r, s) per message");
+        BatchVerifyResult res;
+        this->msgs = &msgs;
+        this->rs = &rs;
+        this->ss = &ss;
+        vector<size_t> idx;
+        rm.assign(msgs.size(), 0);
+        for (size_t i = 0; i < msgs.size(); i++) {
+            if (!inRange(rs[i], ss[i])) {
+                res.failures.push_back(i);   // out of range: not a signature for this key
+                continue;
+            }
+            rm[i] = mont.toMont((u64)rs[i]);
+            idx.push_back(i);
+        }
+        check(idx, pool, res);
+        sort(res.failures.begin(), res.failures.end());
+        res.ok = res.failures.empty();
+        return res;
+    }
+
+    bool inRange(long long r, long long s) const { return r >= 1 && r < p && s >= 0 && s < p - 1; }
+
+    // The whole screen: screenBits subset tests of the Legendre symbols, then `rounds` product tests.
+    // Stops at the first failing test.
+    bool screen(const vector<size_t>& idx, mt19937_64& rng) const {
+        if (!legendreRounds(idx, rng)) return false;
+        for (int round = 0; round < rounds; round++)
+            if (!screenRound(idx, rng)) return false;
+        return true;
+    }
+
+    // g^M == y^r * r^s mapped through the Legendre symbol, (g/p)^M == (y/p)^r * (r/p)^s with exponents
+    // mod p-1, over screenBits random subsets T: (y/p)^(sum r_i) * (prod r_i over odd s_i / p) ==
+    // (g/p)^(sum M_i). Any signature whose error is a non-residue fails a subset with probability 1/2.
+    // One pass over the signatures feeds all subsets: bit t of a random word says whether signature i is
+    // in subset t, the parities are xors of whole words, and each subset costs one Jacobi symbol.
+    bool legendreRounds(const vector<size_t>& idx, mt19937_64& rng) const {
+        u64 all = (1ULL << screenBits) - 1, parityR = 0, parityM = 0;   // bit t: parity of the sums over subset t
+        vector<u64> prod(screenBits, mont.one);
+        for (size_t i : idx) {
+            u64 member = rng() & all;
+            parityR ^= (*rs)[i] & 1 ? member : 0;
+            parityM ^= (*msgs)[i] & 1 ? member : 0;   // p - 1 is even: M mod p-1 has the parity of M
+            if (!((*ss)[i] & 1)) continue;
+            for (u64 w = member; w; w &= w - 1) {
+                int t = __builtin_ctzll(w);
+                prod[t] = mont.mul(prod[t], rm[i]);
+            }
+        }
+        for (int t = 0; t < screenBits; t++) {
+            int left = (chiY < 0 && (parityR >> t & 1) ? -1 : 1) * jacobi(mont.fromMont(prod[t]), (u64)p);
+            if (left != (chiG < 0 && (parityM >> t & 1) ? -1 : 1)) return false;
+        }
+        return true;
+    }
+
+    // One product test with d_i uniform in [1, 2^62): the exponents d_i * s_i mod p-1 are full size
+    // whatever the length of d_i, so long d_i cost nothing extra
+    bool screenRound(const vector<size_t>& idx, mt19937_64& rng) const {
+        u64 order = (u64)p - 1, mask = (1ULL << 62) - 1, sumM = 0, sumR = 0;
+        vector<u64> xs, es;
+        for (size_t i : idx) {
+            u64 d = rng() & mask;
+            while (d == 0) d = rng() & mask;
+            u64 M = (u64)(((*msgs)[i] % (long long)order + (long long)order) % (long long)order);
+            sumM = (u64)(((u128)d * M + sumM) % order);
+            sumR = (u64)(((u128)d * (u64)(*rs)[i] + sumR) % order);
+            xs.push_back(rm[i]);
+            es.push_back((u64)((u128)d * (u64)(*ss)[i] % order));
+        }
+        xs.push_back(ym);
+        es.push_back(sumR);
+        xs.push_back(gm);
+        es.push_back(sumM == 0 ? 0 : order - sumM);   // g^(-sum d_i*M_i)
+        return multiPow64(mont, xs, es, 64 - __builtin_clzll(order)) == mont.one;
+    }
+
+    void check(const vector<size_t>& idx, ThreadPool* pool, BatchVerifyResult& res) {
+        auto leaf = [this](const vector<size_t>& sub, vector<size_t>& failures) {
+            for (size_t i : sub)
+                if (!verify((*msgs)[i], (*rs)[i], (*ss)[i])) failures.push_back(i);
+        };
+        if (rounds > ELGAMAL_MAX_ROUNDS) {
+            // the screen would cost more than verifying every signature
+            if (!pool) return leaf(idx, res.failures);
+            long long chunks = (long long)((idx.size() + ELGAMAL_VERIFY_CHUNK - 1) / ELGAMAL_VERIFY_CHUNK);
+            vector<vector<size_t>> found(chunks);
+            parallelFor(*pool, chunks, [&](long long c) {
+                size_t lo = (size_t)c * ELGAMAL_VERIFY_CHUNK;
+                leaf(vector<size_t>(idx.begin() + lo, idx.begin() + min(idx.size(), lo + ELGAMAL_VERIFY_CHUNK)), found[c]);
+            });
+            for (const vector<size_t>& f : found) res.failures.insert(res.failures.end(), f.begin(), f.end());
+            return;
+        }
+        auto screenFn = [this](const vector<size_t>& sub, mt19937_64& g) { return screen(sub, g); };
+        if (pool) res.screens += bisectFailures(*pool, idx, ELGAMAL_VERIFY_LEAF, screenFn, leaf, rng, res.failures);
+        else res.screens += bisectFailures(idx, false, ELGAMAL_VERIFY_LEAF, screenFn, leaf, rng, res.failures);
+    }
+};
@@ -0,0 +1,370 @@
+/*
+    factor.h — integer factoring engine for the RSA attack demos
+
+    Purpose:
+    - Recover the primes of a small RSA modulus (up to ~128 bits) so the private
+        exponent can be rebuilt with modInverse(e, phi), instead of scanning
+        exponents up to n.
+
+    Stages (factorize runs them in this order):
+    1) trialDivision: mod-30 wheel (skips multiples of 2, 3, 5) up to TRIAL_LIMIT,
+        split into segments across the pool.
+    2) pollardBrent: Brent's cycle-finding variant of Pollard's rho for cofactors
+        below 2^62. |x - y| values are multiplied together and a gcd is taken only
+        every RHO_BATCH steps (with backtracking if the batch overshoots).
+        Each worker races with a different polynomial x^2 + c.
+    3) ecmCurve: Lenstra's elliptic-curve method on Montgomery curves (Suyama
+        parametrisation), Montgomery ladder for stage 1 and the baby-step /
+        giant-step standard continuation (D = 210) for stage 2.
+        Curves are spread over the pool; the first factor found stops the rest.
+
+    Primality tests (to know when a cofactor is done) and the sieve used by
+    stage 2 come from primes.h.
+
+    Notes:
+    - Everything reuses the Montgomery contexts from modarith.h / bignum.h.
+    - Fine for demo-sized moduli; real RSA moduli (2048-bit) are far out of reach.
+*/
+
+#pragma once
+
+#include "primes.h"
+
+const u64 TRIAL_LIMIT = 1 << 16;   // trial division bound
+const int RHO_BATCH = 128;         // rho steps between gcds
+
+// ---- stage 1: trial division ----
+
+// Removes every prime factor <= limit from n (in place) and returns them with multiplicity.
+// Candidates follow the mod-30 wheel; the range is cut into segments run on the pool.
+inline vector<u64> trialDivision(BigInt& n, u64 limit, ThreadPool& pool) {
+    vector<u64> found;
+    for (u64 p : {2, 3, 5}) {
+        while (!n.isZero() && n.modU64(p) == 0) {
+            found.push_back(p);
+            n /= BigInt((long long)p);
+        }
+    }
+    static const int gaps[8] = {4, 2, 4, 2, 4, 6, 2, 6};   // 7, 11, 13, 17, 19, 23, 29, 31, 37, ...
+    const u64 SEGMENT = 30 * 4096;
+    long long segments = (long long)((limit + SEGMENT - 1) / SEGMENT);
+    vector<vector<u64>> hits(segments);
+    const BigInt& target = n;
+    parallelFor(pool, segments, [&](long long s) {
+        u64 lo = s * SEGMENT, hi = min(limit + 1, lo + SEGMENT);
+        // lo is a multiple of 30: the wheel starts at lo + 1 (gap 6 to lo + 7), or at 7 in the first segment
+        u64 p = s ? lo + 1 : 7;
+        for (int g = s ? 7 : 0; p < hi; p += gaps[g], g = (g + 1) & 7) {
+            if (target.modU64(p) == 0) hits[s].push_back(p);
+        }
+    });
+    for (auto& seg : hits) {
+        for (u64 p : seg) {
+            while (n.modU64(p) == 0) {
+                found.push_back(p);
+                n /= BigInt((long long)p);
+            }
+        }
+    }
+    return found;
+}
+
+// ---- stage 2: Pollard–Brent rho ----
+
+// One rho attempt with f(x) = x^2 + c, starting at x0; returns a divisor of n (n on failure)
+inline u64 pollardBrent(u64 n, u64 c, u64 x0, const atomic<bool>& stop) {
+    Montgomery mont(n);
+    u64 cm = mont.toMont(c), y = mont.toMont(x0), x = y, ys = y, q = mont.one;
+    auto f = [&](u64 v) {
+        u64 r = mont.mul(v, v) + cm;
+        return r >= n ? r - n : r;
+    };
+    u64 g = 1;
+    for (u64 r = 1; g == 1; r <<= 1) {
+        x = y;
+        for (u64 i = 0; i < r; i++) y = f(y);
+        for (u64 k = 0; k < r && g == 1; k += RHO_BATCH) {
+            if (stop) return n;
+            ys = y;
+            for (u64 i = 0; i < min((u64)RHO_BATCH, r - k); i++) {
+                y = f(y);
+                q = mont.mul(q, x > y ? x - y : y - x);
+            }
+            g = (u64)gcd((long long)q, (long long)n);
+        }
+    }
+    if (g == n) {
+        // the batch overshot: replay it one step at a time
+        do {
+            ys = f(ys);
+            g = (u64)gcd((long long)(x > ys ? x - ys : ys - x), (long long)n);
+        } while (g == 1);
+    }
+    return g;
+}
+
+// Non-trivial divisor of an odd composite n < 2^62; each worker tries its own c values
+inline u64 findFactorRho(u64 n, ThreadPool& pool) {
+    atomic<bool> stop(false);
+    atomic<u64> nextC(1), result(0);
+    parallelFor(pool, pool.size(), [&](long long) {
+        while (!stop) {
+            u64 c = nextC++;
+            u64 g = pollardBrent(n, c, 2 + c, stop);
+            if (g != 1 && g != n) {
+                u64 expected = 0;
+                result.compare_exchange_strong(expected, g);
+                stop = true;
+            }
+        }
+    });
+    return result;
+}
+
+// ---- stage 3: elliptic-curve method ----
+
+// Point in projective x-only (X : Z) coordinates on a Montgomery curve
+struct XZPoint {
+    vector<u64> X, Z;
+};
+
+// Montgomery curve B*y^2 = x^3 + A*x^2 + x over Z/nZ, arithmetic in BigMontgomery form.
+// Holds scratch vectors, so use one curve object per thread.
+struct MontgomeryCurve {
+    const BigMontgomery& M;
+    int k;
+    vector<u64> a24;   // (A + 2) / 4
+    mutable vector<u64> t1, t2, t3, t4;
+
+    MontgomeryCurve(const BigMontgomery& mont, const vector<u64>& a24_)
+        : M(mont), k(mont.k), a24(a24_), t1(k), t2(k), t3(k), t4(k) {}
+
+    // r = a + b mod n (r may alias a or b)
+    void addMod(vector<u64>& r, const vector<u64>& a, const vector<u64>& b) const {
+        r.resize(k);
+        u64 carry = 0;
+        for (int i = 0; i < k; i++) {
+            u128 s = (u128)a[i] + b[i] + carry;
+            r[i] = (u64)s;
+            carry = (u64)(s >> 64);
+        }
+        bool ge = carry != 0;
+        if (!ge) {
+            ge = true;
+            for (int i = k - 1; i >= 0; i--) {
+                if (r[i] != M.n[i]) {
+                    ge = r[i] > M.n[i];
+                    break;
+                }
+            }
+        }
+        if (ge) subLimbs(r.data(), M.n.data(), k);
+    }
+
+    // r = a - b mod n (r may alias a or b)
+    void subMod(vector<u64>& r, const vector<u64>& a, const vector<u64>& b) const {
+        r.resize(k);
+        u64 borrow = 0;
+        for (int i = 0; i < k; i++) {
+            u128 d = (u128)a[i] - b[i] - borrow;
+            r[i] = (u64)d;
+            borrow = (u64)(d >> 64) ? 1 : 0;
+        }
+        if (borrow) addLimbs(r.data(), M.n.data(), k);
+    }
+
+    // Q = 2P (Q may alias P)
+    void dbl(XZPoint& Q, const XZPoint& P) const {
+        addMod(t1, P.X, P.Z);
+        M.sqrInto(t1, t1);           // (X+Z)^2
+        subMod(t2, P.X, P.Z);
+        M.sqrInto(t2, t2);           // (X-Z)^2
+        subMod(t3, t1, t2);          // 4XZ
+        M.mulInto(Q.X, t1, t2);
+        M.mulInto(t4, a24, t3);
+        addMod(t4, t4, t2);
+        M.mulInto(Q.Z, t3, t4);
+    }
+
+    // R = P + Q, given D = P - Q (R may alias P or Q, not D)
+    void add(XZPoint& R, const XZPoint& P, const XZPoint& Q, const XZPoint& D) const {
+        subMod(t1, P.X, P.Z);
+        addMod(t3, Q.X, Q.Z);
+        M.mulInto(t1, t1, t3);       // (XP - ZP)(XQ + ZQ)
+        addMod(t2, P.X, P.Z);
+        subMod(t4, Q.X, Q.Z);
+        M.mulInto(t2, t2, t4);       // (XP + ZP)(XQ - ZQ)
+        addMod(t3, t1, t2);
+        M.sqrInto(t3, t3);
+        subMod(t4, t1, t2);
+        M.sqrInto(t4, t4);
+        M.mulInto(R.X, D.Z, t3);
+        M.mulInto(R.Z, D.X, t4);
+    }
+
+    // [m]P with the Montgomery ladder (m >= 1)
+    XZPoint ladder(const XZPoint& P, u64 m) const {
+        XZPoint R0 = P, R1;
+        dbl(R1, P);
+        for (int i = 62 - __builtin_clzll(m); i >= 0; i--) {
+            if ((m >> i) & 1) {
+                add(R0, R0, R1, P);
+                dbl(R1, R1);
+            } else {
+                add(R1, R0, R1, P);
+                dbl(R0, R0);
+            }
+        }
+        return R0;
+    }
+};
+
+// One ECM curve (Suyama sigma); returns a non-trivial factor of n or 0
+inline BigInt ecmCurve(const BigInt& n, u64 sigma, u64 B1, u64 B2, const vector<bool>& isPrimeTab, const atomic<bool>& stop) {
+    BigInt s = BigInt((long long)sigma);
+    BigInt u = (s * s - 5) % n, v = 4 * s % n;
+    if (u.neg) u += n;
+    BigInt u3 = u * u % n * u % n;
+    BigInt num = (v - u) % n;
+    if (num.neg) num += n;
+    num = num * num % n * num % n * ((3 * u + v) % n) % n;
+    BigInt den = 16 * u3 % n * v % n;
+    BigInt g = gcd(den, n);
+    if (g != BigInt(1)) return g != n ? g : BigInt(0);
+
+    BigMontgomery M(n);
+    MontgomeryCurve curve(M, M.toMont(num * modInverse(den, n) % n));
+    XZPoint Q{M.toMont(u3), M.toMont(v * v % n * v % n)};
+
+    // stage 1: Q = [prod of prime powers <= B1] Q
+    int steps = 0;
+    for (u64 p = 2; p <= B1; p++) {
+        if (!isPrimeTab[p]) continue;
+        u64 q = p;
+        while (q <= B1 / p) q *= p;
+        Q = curve.ladder(Q, q);
+        if (++steps % 256 == 0 && stop) return BigInt(0);
+    }
+    g = gcd(M.fromMont(Q.Z), n);
+    if (g != BigInt(1)) return g != n ? g : BigInt(0);
+
+    // stage 2: primes q in (B1, B2] written as m*D +- j, accumulate X_R*Z_j - X_j*Z_R
+    const u64 D = 210;
+    vector<u64> js;
+    vector<XZPoint> baby;
+    for (u64 j = 1; j < D / 2; j += 2) {
+        if (std::gcd(j, D) == 1) {
+            js.push_back(j);
+            baby.push_back(curve.ladder(Q, j));
+        }
+    }
+    XZPoint G = curve.ladder(Q, D);
+    u64 m0 = max<u64>(1, B1 / D), mEnd = B2 / D + 1;
+    XZPoint prev = m0 > 1 ? curve.ladder(Q, (m0 - 1) * D) : Q;
+    XZPoint R = curve.ladder(Q, m0 * D);
+    if (m0 == 1) {
+        // [0*D]Q is the point at infinity, so seed the recurrence with [2D]Q - [D]Q instead
+        prev = R;
+        R = curve.ladder(Q, 2 * D);
+        m0 = 2;
+    }
+    vector<u64> acc = M.one, a(M.k), b(M.k);
+    for (u64 m = m0; m <= mEnd; m++) {
+        u64 c = m * D;
+        for (size_t i = 0; i < js.size(); i++) {
+            u64 lo = c - js[i], hi = c + js[i];
+            bool hit = (lo > B1 && lo <= B2 && isPrimeTab[lo]) || (hi > B1 && hi <= B2 && isPrimeTab[hi]);
+            if (!hit) continue;
+            M.mulInto(a, R.X, baby[i].Z);
+            M.mulInto(b, baby[i].X, R.Z);
+            curve.subMod(a, a, b);
+            M.mulInto(acc, acc, a);
+        }
+        XZPoint next;
+        curve.add(next, R, G, prev);
+        prev = move(R);
+        R = move(next);
+        if ((m & 63) == 0 && stop) return BigInt(0);
+    }
+    g = gcd(M.fromMont(acc), n);
+    return g != BigInt(1) && g != n ? g : BigInt(0);
+}
+
+// ECM effort levels (GMP-ECM's recommended B1 / curve counts by factor size in digits)
+struct ECMLevel {
+    int digits;
+    u64 B1;
+    int curves;
+};
+const ECMLevel ECM_LEVELS[] = {{15, 2000, 25}, {20, 11000, 90}, {25, 50000, 300}, {30, 250000, 700}};
+
+// Non-trivial factor of composite n, or 0 if all levels fail
+inline BigInt findFactorECM(const BigInt& n, ThreadPool& pool) {
+    for (const ECMLevel& level : ECM_LEVELS) {
+        u64 B2 = 100 * level.B1;
+        vector<bool> isPrimeTab = primeSieve(B2 + 2 * 210);
+        atomic<bool> stop(false);
+        mutex mtx;
+        BigInt factor;
+        parallelFor(pool, level.curves, [&](long long c) {
+            if (stop) return;
+            u64 sigma = 6 + (u64)level.digits * 1000003 + (u64)c * 7919;
+            BigInt f = ecmCurve(n, sigma, level.B1, B2, isPrimeTab, stop);
+            if (!f.isZero()) {
+                lock_guard<mutex> lock(mtx);
+                if (factor.isZero()) factor = f;
+                stop = true;
+            }
+        });
+        if (!factor.isZero()) return factor;
+    }
+    return BigInt(0);
+}
+
+// ---- driver ----
+
+struct FactorStats {
+    double trialMs = 0, rhoMs = 0, ecmMs = 0;
+    vector<BigInt> unfactored;   // composites every method gave up on
+};
+
+// Prime factors of n > 0 with multiplicity, sorted
+inline vector<BigInt> factorize(BigInt n, ThreadPool& pool, FactorStats* stats = nullptr) {
+    using clk = chrono::steady_clock;
+    auto ms = [](clk::time_point a) { return chrono::duration<double, milli>(clk::now() - a).count(); };
+    FactorStats local;
+    FactorStats& st = stats ? *stats : local;
+
+    vector<BigInt> primes;
+    auto t = clk::now();
+    for (u64 p : trialDivision(n, TRIAL_LIMIT, pool)) primes.push_back(BigInt((long long)p));
+    st.trialMs += ms(t);
+
+    vector<BigInt> work;
+    if (n > BigInt(1)) work.push_back(n);
+    while (!work.empty()) {
+        BigInt m = work.back();
+        work.pop_back();
+        if (isProbablePrime(m)) {
+            primes.push_back(m);
+            continue;
+        }
+        BigInt f;
+        t = clk::now();
+        if (m.bitLength() <= 62) {
+            f = BigInt((long long)findFactorRho(m.low(), pool));
+            st.rhoMs += ms(t);
+        } else {
+            f = findFactorECM(m, pool);
+            st.ecmMs += ms(t);
+        }
+        if (f.isZero()) {
+            st.unfactored.push_back(m);
+            continue;
+        }
+        work.push_back(f);
+        work.push_back(m / f);
+    }
+    sort(primes.begin(), primes.end());
+    return primes;
+}
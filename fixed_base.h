@@ -0,0 +1,80 @@
+/*
+    fixed_base.h — precomputed powers of a fixed base (g^k, h^k for one ElGamal key)
+
+    Purpose:
+    - Every ElGamal encryption computes g^k and h^k for a fresh k, with g and h
+        fixed for the life of the public key. A generic power pays ~63 squarings
+        plus ~31 multiplications for a 63-bit k. FixedBase spends that work once,
+        when the key is loaded, so each later power is a handful of multiplications
+        and no squarings.
+
+    Method (BGMW fixed-base windowing):
+    - k is split into w-bit digits, k = sum d_i * 2^(w*i). The table stores
+        base^(d * 2^(w*i)) for every window i and digit d = 1 .. 2^w - 1, so
+        base^k = product over i of table[i][d_i]: at most ceil(bits / w)
+        multiplications, one table lookup each, no squarings.
+
+    Table size (the width w is the knob):
+        w   entries (63-bit k)   multiplications per power
+        2        96                  32
+        4       240                  16
+        6       693                  11
+        8      2040                   8
+    - Entries are one residue each (8 bytes for ModInt / DynModInt); building
+        costs about one multiplication per entry, so it pays for itself after
+        a few powers. FIXED_BASE_WIDTH = 6 keeps the table (~5.5 KB) in L1.
+
+    Notes:
+    - T is any residue type with * and construction from 1: ModInt<P> or
+        DynModInt (modint.h). For DynModInt, set the modulus before building.
+    - The table lookup is indexed by the digits of k, so the access pattern
+        depends on the (secret) exponent: fine for these demos, not constant time.
+*/
+
+#pragma once
+
+#include "modint.h"
+
+const int FIXED_BASE_WIDTH = 6;   // default window width: table of ceil(bits/6) * 63 entries
+
+template <class T>
+class FixedBase {
+public:
+    // Table for exponents below 2^bits, with w-bit windows (1 <= w <= 16, 1 <= bits <= 64)
+    explicit FixedBase(const T& base, int w = FIXED_BASE_WIDTH, int bits = 63) : w(w), bits(bits), one(1) {
+        if (w < 1 || w > 16) throw invalid_argument("FixedBase window width must be between 1 and 16");
+        if (bits < 1 || bits > 64) throw invalid_argument("FixedBase exponent size must be between 1 and 64 bits");
+        rows = (bits + w - 1) / w;
+        perRow = ((size_t)1 << w) - 1;
+        table.reserve(rows * perRow);
+        T b = base;   // base^(2^(w*i)) for the current row i
+        for (int i = 0; i < rows; i++) {
+            T x = b;
+            for (size_t d = 1; d <= perRow; d++) {
+                table.push_back(x);
+                x *= b;   // after the last digit, x = b^(2^w): the next row's base
+            }
+            b = x;
+        }
+    }
+
+    // base^e for 0 <= e < 2^bits
+    T pow(u64 e) const {
+        if (bits < 64 && (e >> bits) != 0) throw invalid_argument("exponent is wider than the FixedBase table");
+        u64 mask = perRow;
+        T r = one;
+        for (const T* row = table.data(); e != 0; e >>= w, row += perRow)
+            if (e & mask) r *= row[(e & mask) - 1];
+        return r;
+    }
+
+    int width() const { return w; }
+    size_t entries() const { return table.size(); }
+    size_t bytes() const { return table.size() * sizeof(T); }
+
+private:
+    int w, bits, rows;
+    size_t perRow;   // digits 1 .. 2^w - 1
+    T one;
+    vector<T> table;   // row i, digit d at [i * perRow + d - 1]
+};
@@ -0,0 +1,285 @@
+/*
+    modarith.h — shared modular-arithmetic core for the RSA / ElGamal demos
+
+    Purpose:
+    - One copy of the helpers every public-key program used to carry on its own
+        (gcd, power, modInverse), so fixes and speedups land everywhere at once.
+    - Header-only: each demo still builds on its own with `g++ File.cpp`.
+
+    Contents:
+    - gcd: greatest common divisor (Euclid)
+    - mulMod: overflow-safe (a * b) % m through a 128-bit product
+    - slidingWindowPow / fixedWindowPow: exponentiation engine shared by the
+        64-bit and multi-limb (bignum.h) Montgomery contexts
+    - Montgomery: Montgomery-form arithmetic for an odd modulus n < 2^63
+    - power: fast modular exponentiation (Montgomery for odd moduli)
+    - powerConstTime: fixed-window exponentiation for secret exponents
+    - modInverse: modular inverse; binary extended GCD (modInverseBinary) for odd
+        moduli, extended Euclid (modInverseEuclid) for even ones
+
+    Why Montgomery:
+    - The old `power` did `(res * a) % mod` on long long, which silently overflows
+        once mod > 2^31 and pays for a hardware divide on every step.
+    - In Montgomery form a product is reduced with two multiplications and a shift
+        (REDC), so the exponentiation loop has no divisions at all and works for
+        any odd modulus up to 63 bits. Even moduli fall back to mulMod.
+
+    Notes:
+    - Values are kept in `long long` at the interface to match the demos.
+    - Still educational code: only powerConstTime is meant for secret exponents,
+        everything else is variable-time.
+*/
+
+#pragma once
+
+#include <bits/stdc++.h>
+using namespace std;
+
+typedef unsigned long long u64;
+typedef unsigned __int128 u128;
+
+// Compute greatest common divisor (Euclid's algorithm)
+inline long long gcd(long long a, long long b) {
+    while (b != 0) {
+        long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Overflow-safe (a * b) % m for 0 <= a, b < m < 2^63
+inline long long mulMod(long long a, long long b, long long m) {
+    return (long long)((u128)(u64)a * (u64)b % (u64)m);
+}
+
+// ---- Windowed exponentiation engine ----
+//
+// Works with any context that provides
+//   Elem one;
+//   void mulInto(Elem& out, const Elem& a, const Elem& b) const;   (out may alias a or b)
+//   void sqrInto(Elem& out, const Elem& a) const;
+//   void select(Elem& out, const vector<Elem>& table, u64 idx) const;   (reads every entry)
+// The exponent is passed as a bit count plus an accessor bit(i) (0 beyond the top).
+
+// Window width for a `bits`-bit exponent (the break points OpenSSL uses)
+inline int windowWidth(int bits) {
+    if (bits > 671) return 6;
+    if (bits > 239) return 5;
+    if (bits > 79) return 4;
+    if (bits > 23) return 3;
+    return 1;
+}
+
+// Left-to-right sliding window over a table of odd powers base^1, base^3, ..., base^(2^w - 1).
+// Every window starts and ends on a 1 bit, so a w-bit window costs one multiplication;
+// plain square-and-multiply pays one per set bit (about bits/2), this pays about bits/(w+1).
+template <class Ctx, class Elem, class BitFn>
+Elem slidingWindowPow(const Ctx& ctx, const Elem& base, int bits, BitFn bit) {
+    int w = windowWidth(bits);
+    vector<Elem> odd(1 << (w - 1), base);
+    if (w > 1) {
+        Elem base2 = base;
+        ctx.sqrInto(base2, base);
+        for (size_t i = 1; i < odd.size(); i++) ctx.mulInto(odd[i], odd[i - 1], base2);
+    }
+
+    Elem res = ctx.one;
+    bool started = false;
+    int i = bits - 1;
+    while (i >= 0) {
+        if (!bit(i)) {
+            if (started) ctx.sqrInto(res, res);
+            i--;
+            continue;
+        }
+        // longest window [l..i] of at most w bits that ends on a set bit
+        int l = max(i - w + 1, 0);
+        while (!bit(l)) l++;
+        u64 val = 0;
+        for (int j = i; j >= l; j--) val = (val << 1) | (bit(j) ? 1 : 0);
+        if (started) {
+            for (int j = 0; j <= i - l; j++) ctx.sqrInto(res, res);
+            ctx.mulInto(res, res, odd[val >> 1]);
+        } else {
+            res = odd[val >> 1];
+            started = true;
+        }
+        i = l - 1;
+    }
+    return res;
+}
+
+// Fixed-window exponentiation for secret exponents: always `bits` squarings and one
+// multiplication per w-bit window, with the table entry picked by a full scan
+// (ctx.select), so neither the operation sequence nor the table access pattern
+// depends on the exponent bits. `bits` must be a public bound, not the exponent length.
+template <class Ctx, class Elem, class BitFn>
+Elem fixedWindowPow(const Ctx& ctx, const Elem& base, int bits, BitFn bit) {
+    int w = max(windowWidth(bits), 2);
+    vector<Elem> table(1 << w, ctx.one);
+    table[1] = base;
+    for (size_t i = 2; i < table.size(); i++) ctx.mulInto(table[i], table[i - 1], base);
+
+    Elem res = ctx.one, sel = ctx.one;
+    for (int win = (bits + w - 1) / w - 1; win >= 0; win--) {
+        for (int j = 0; j < w; j++) ctx.sqrInto(res, res);
+        u64 idx = 0;
+        for (int j = w - 1; j >= 0; j--) idx = (idx << 1) | (bit(win * w + j) ? 1 : 0);
+        ctx.select(sel, table, idx);
+        ctx.mulInto(res, res, sel);
+    }
+    return res;
+}
+
+// Montgomery arithmetic modulo an odd n < 2^63 with R = 2^64.
+// Values handled by mul/sqr/pow are in Montgomery form (x * R mod n).
+// The constructor and the scalar operations are constexpr, so a modulus known at compile time
+// gets all of its constants folded (see modint.h).
+struct Montgomery {
+    u64 n = 0;     // modulus (odd)
+    u64 nInv = 0;  // n^{-1} mod 2^64
+    u64 r2 = 0;    // R^2 mod n, used to enter Montgomery form
+    u64 one = 0;   // R mod n, i.e. 1 in Montgomery form
+
+    constexpr explicit Montgomery(u64 mod) : n(mod) {
+        // Newton iteration: each step doubles the number of correct low bits
+        nInv = n;
+        for (int i = 0; i < 5; i++) nInv *= 2 - n * nInv;
+        r2 = (u64)(-(u128)n % n);
+        one = (u64)(((u128)1 << 64) % n);
+    }
+
+    // REDC: returns T * R^{-1} mod n for T < n * R
+    constexpr u64 reduce(u128 T) const {
+        u64 m = (u64)T * nInv;
+        u64 t = (u64)(T >> 64) - (u64)(((u128)m * n) >> 64);
+        return (long long)t < 0 ? t + n : t;
+    }
+
+    constexpr u64 toMont(u64 x) const { return reduce((u128)(x % n) * r2); }
+    constexpr u64 fromMont(u64 x) const { return reduce(x); }
+    constexpr u64 mul(u64 a, u64 b) const { return reduce((u128)a * b); }
+
+    // Engine interface (see slidingWindowPow)
+    void mulInto(u64& out, u64 a, u64 b) const { out = mul(a, b); }
+    void sqrInto(u64& out, u64 a) const { out = mul(a, a); }
+    void select(u64& out, const vector<u64>& table, u64 idx) const {
+        u64 r = 0;
+        for (size_t i = 0; i < table.size(); i++) r |= table[i] & ((u64)0 - (u64)(i == idx));
+        out = r;
+    }
+
+    // a^b with a already in Montgomery form; result stays in Montgomery form
+    u64 pow(u64 a, u64 b) const {
+        if (b == 0) return one;
+        return slidingWindowPow(*this, a, 64 - __builtin_clzll(b), [b](int i) { return (b >> i) & 1; });
+    }
+
+    // Same as pow, fixed-window over all 64 exponent bits (for secret exponents)
+    u64 powConstTime(u64 a, u64 b) const {
+        return fixedWindowPow(*this, a, 64, [b](int i) { return i < 64 && ((b >> i) & 1); });
+    }
+};
+
+// Fast modular exponentiation: computes (a^b) % mod in O(log b) time.
+// Odd moduli use Montgomery form, even moduli use 128-bit mulMod.
+inline long long power(long long a, long long b, long long mod) {
+    if (mod == 1) return 0;
+    if (b <= 0) return 1;
+    a %= mod;
+    if (a < 0) a += mod;
+    if (mod & 1) {
+        Montgomery mont(mod);
+        return (long long)mont.fromMont(mont.pow(mont.toMont(a), b));
+    }
+    long long res = 1;
+    while (b > 0) {
+        if (b & 1) res = mulMod(res, a, mod);
+        a = mulMod(a, a, mod);
+        b >>= 1;
+    }
+    return res;
+}
+
+// (a^b) % mod for a secret exponent b (fixed-window, odd moduli only; even moduli use power)
+inline long long powerConstTime(long long a, long long b, long long mod) {
+    if (mod == 1) return 0;
+    if (b <= 0) return 1;
+    if (!(mod & 1)) return power(a, b, mod);
+    a %= mod;
+    if (a < 0) a += mod;
+    Montgomery mont(mod);
+    return (long long)mont.fromMont(mont.powConstTime(mont.toMont(a), b));
+}
+
+// Modular inverse using the Extended Euclidean Algorithm
+// Returns x such that (a * x) % m == 1 when gcd(a,m) == 1
+inline long long modInverseEuclid(long long a, long long m) {
+    long long m0 = m, y = 0, x = 1;
+    if (m == 1) return 0;
+    a %= m;
+    if (a < 0) a += m;
+
+    while (a > 1) {
+        long long q = a / m;
+        long long t = m;
+        m = a % m, a = t;
+        t = y;
+        y = x - q * y;
+        x = t;
+    }
+
+    if (x < 0) x += m0;
+    return x;
+}
+
+// Binary extended GCD (Kaliski's almost inverse) for an odd m < 2^63 and 0 <= a < m.
+// Only subtractions and shifts run in the loop: both values are kept odd, the larger
+// one loses the smaller and its trailing zeros are stripped in one shift, while the
+// cofactors r, s (both <= m) are only added and doubled. That leaves a^{-1} * 2^k for
+// a known k <= 126, and two Montgomery reductions divide the 2^k back out.
+// Returns 0 when gcd(a, m) != 1.
+inline u64 modInverseBinary(u64 a, u64 m) {
+    if (a == 0) return 0;
+    // invariants: m = u*s + v*r,  a*r == -sign*u*2^k,  a*s == sign*v*2^k  (mod m)
+    u64 u = m, v = a, r = 0, s = 1, flip = 0;
+    int k = __builtin_ctzll(v);
+    v >>= k;
+    while (true) {
+        u64 swapMask = (u64)0 - (u64)(u < v);   // keep u >= v without a branch
+        u64 t = (u ^ v) & swapMask;
+        u ^= t, v ^= t;
+        t = (s ^ r) & swapMask;
+        s ^= t, r ^= t;
+        flip ^= swapMask;
+        u64 diff = u - v;
+        if (diff == 0) break;
+        int tz = __builtin_ctzll(diff);
+        r += s;
+        u = diff >> tz;
+        s <<= tz;
+        k += tz;
+    }
+    if (u != 1) return 0;
+    // s * 2^-k mod m by REDC (R = 2^64), once or twice depending on k
+    u64 nInv = m;
+    for (int i = 0; i < 5; i++) nInv *= 2 - m * nInv;
+    auto redc = [m, nInv](u128 T) {
+        u64 q = (u64)T * nInv;
+        u64 t = (u64)(T >> 64) - (u64)(((u128)q * m) >> 64);
+        return (long long)t < 0 ? t + m : t;
+    };
+    u64 x = k <= 64 ? redc((u128)s << (64 - k)) : redc((u128)redc(s) << (128 - k));
+    return flip && x ? m - x : x;
+}
+
+// Modular inverse: binary extended GCD for odd m, extended Euclid otherwise
+// Returns x such that (a * x) % m == 1 when gcd(a,m) == 1
+inline long long modInverse(long long a, long long m) {
+    if (m == 1) return 0;
+    if (!(m & 1) || m < 0) return modInverseEuclid(a, m);
+    a %= m;
+    if (a < 0) a += m;
+    return (long long)modInverseBinary((u64)a, (u64)m);
+}
@@ -0,0 +1,312 @@
+/*
+    primes.h — primality testing and random prime generation
+
+    Purpose:
+    - The demos used to ask the user to type p and q (or p for ElGamal) and never
+        checked that they were prime. This header tests user input and generates
+        primes of a requested size for RSA / ElGamal key setup.
+
+    Contents:
+    - isPrime: deterministic Miller–Rabin for 64-bit values
+    - isProbablePrime: Miller–Rabin with the first `rounds` prime bases (BigInt)
+    - isProbablePrimeBPSW: Baillie–PSW = strong base-2 Miller–Rabin + strong
+        Lucas test (Selfridge parameters); no composite is known to pass it
+    - primeSieve: plain sieve of Eratosthenes up to a limit
+    - randomPrime: random prime with exactly `bits` bits, searched by every
+        worker of a ThreadPool at once (the first prime found wins), or on the
+        calling thread with a caller-supplied RNG
+    - raceWorkers: the first-result-wins worker race behind randomPrime, for
+        other searches (safe primes, Schnorr groups in elgamal_params.h)
+
+    How randomPrime searches:
+    1) Each worker picks a random odd start (top two bits set, so the product of
+        two such primes has exactly twice the bits) with its own RNG.
+    2) Segmented sieve: the window of SIEVE_WINDOW odd numbers after the start is
+        crossed off by every odd prime below SIEVE_LIMIT, using one start % p per
+        prime. About 90% of the candidates die here without any exponentiation.
+    3) Survivors go through base-2 Miller–Rabin (cheap rejection), then BPSW.
+    4) A shared flag stops the other workers once one of them has a prime.
+
+    Notes:
+    - The RNG is std::mt19937_64 seeded from std::random_device: fine for demos,
+        not a cryptographically secure key generator.
+*/
+
+#pragma once
+
+#include "bignum.h"
+#include "thread_pool.h"
+
+const u64 SIEVE_LIMIT = 1 << 16;   // small primes used to sieve a candidate window
+const int SIEVE_WINDOW = 4096;     // odd candidates per window
+
+// a^b mod n for any 64-bit n (Montgomery needs n < 2^63, so large n use 128-bit %)
+inline u64 powMod64(u64 a, u64 b, u64 n) {
+    if (n < (1ULL << 63) && (n & 1)) return (u64)power((long long)(a % n), (long long)b, (long long)n);
+    u64 res = 1 % n;
+    a %= n;
+    while (b > 0) {
+        if (b & 1) res = (u64)((u128)res * a % n);
+        a = (u64)((u128)a * a % n);
+        b >>= 1;
+    }
+    return res;
+}
+
+// Deterministic Miller–Rabin for 64-bit n (these 12 bases are exact below 3.3 * 10^24)
+inline bool isPrime(u64 n) {
+    if (n < 2) return false;
+    static const u64 bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    for (u64 p : bases) {
+        if (n % p == 0) return n == p;
+    }
+    u64 d = n - 1;
+    int s = 0;
+    while (!(d & 1)) d >>= 1, s++;
+    for (u64 a : bases) {
+        u64 x = powMod64(a, d, n);
+        if (x == 1 || x == n - 1) continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; r++) {
+            x = (u64)((u128)x * x % n);
+            if (x == n - 1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+// Miller–Rabin with the first `rounds` prime bases (exact path for n < 2^64)
+inline bool isProbablePrime(const BigInt& n, int rounds = 16) {
+    if (n.neg) return false;
+    if (n.bitLength() <= 64) return isPrime(n.low());
+    static const u64 small[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71};
+    for (u64 p : small) {
+        if (n.modU64(p) == 0) return false;
+    }
+    BigInt nm1 = n - 1, d = nm1;
+    int s = 0;
+    while (!d.isOdd()) d >>= 1, s++;
+    BigMontgomery mont(n);
+    for (int i = 0; i < rounds && i < 20; i++) {
+        BigInt x = mont.pow(BigInt((long long)small[i]), d);
+        if (x == BigInt(1) || x == nm1) continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; r++) {
+            x = x * x % n;
+            if (x == nm1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+// Jacobi symbol (a / n) for odd n
+inline int jacobi(u64 a, u64 n) {
+    int sign = 1;
+    a %= n;
+    while (a != 0) {
+        while (!(a & 1)) {
+            a >>= 1;
+            if ((n & 7) == 3 || (n & 7) == 5) sign = -sign;
+        }
+        swap(a, n);
+        if ((a & 3) == 3 && (n & 3) == 3) sign = -sign;
+        a %= n;
+    }
+    return n == 1 ? sign : 0;
+}
+
+// Jacobi symbol (D / n) for a small signed D and a big odd n > |D|
+inline int jacobi(long long D, const BigInt& n) {
+    int sign = 1;
+    u64 a = D < 0 ? (u64)(-D) : (u64)D;
+    if (D < 0 && (n.low() & 3) == 3) sign = -sign;   // (-1 / n)
+    while (a && !(a & 1)) {
+        a >>= 1;
+        if ((n.low() & 7) == 3 || (n.low() & 7) == 5) sign = -sign;
+    }
+    if (a == 1) return sign;
+    if ((a & 3) == 3 && (n.low() & 3) == 3) sign = -sign;   // quadratic reciprocity
+    return sign * jacobi(n.modU64(a), a);
+}
+
+// floor(sqrt(n)) for n >= 0 (Newton's method)
+inline BigInt isqrt(const BigInt& n) {
+    if (n.isZero()) return n;
+    BigInt x = BigInt(1) << ((n.bitLength() + 1) / 2);
+    while (true) {
+        BigInt y = (x + n / x) >> 1;
+        if (y >= x) return x;
+        x = y;
+    }
+}
+
+// Strong Lucas probable-prime test with Selfridge's method A: D is the first of
+// 5, -7, 9, -11, ... with (D / n) = -1, P = 1, Q = (1 - D) / 4. With n + 1 = d * 2^s,
+// n passes if U_d == 0 or V_(d * 2^r) == 0 (mod n) for some 0 <= r < s.
+inline bool isStrongLucasProbablePrime(const BigInt& n) {
+    if (!n.isOdd() || n < BigInt(3)) return n == BigInt(2);
+    long long D = 5;
+    for (int tries = 0;; tries++) {
+        int j = jacobi(D, n);
+        if (j == -1) break;
+        if (j == 0 && BigInt(D < 0 ? -D : D) != n) return false;   // shares a factor with D
+        if (tries == 8) {
+            BigInt r = isqrt(n);
+            if (r * r == n) return false;   // squares never give (D / n) = -1
+        }
+        D = D > 0 ? -(D + 2) : -D + 2;
+    }
+    BigInt Dm = BigInt(D) % n, Q = BigInt((1 - D) / 4) % n;
+    if (Dm.neg) Dm += n;
+    if (Q.neg) Q += n;
+
+    auto half = [&n](BigInt x) { return (x.isOdd() ? x + n : x) >> 1; };   // x / 2 mod n
+    BigInt d = n + 1;
+    int s = 0;
+    while (!d.isOdd()) d >>= 1, s++;
+
+    // U_1 = 1, V_1 = P = 1, Q^1, then left-to-right over the bits of d
+    BigInt U = 1, V = 1, Qk = Q;
+    for (int i = d.bitLength() - 2; i >= 0; i--) {
+        U = U * V % n;
+        V = (V * V - Qk - Qk) % n;
+        if (V.neg) V += n;
+        Qk = Qk * Qk % n;
+        if (d.bit(i)) {
+            BigInt U1 = half(U + V);          // U_(k+1) = (P U_k + V_k) / 2
+            V = half((Dm * U + V) % n);       // V_(k+1) = (D U_k + P V_k) / 2
+            U = U1 % n;
+            Qk = Qk * Q % n;
+        }
+    }
+    if (U.isZero() || V.isZero()) return true;
+    for (int r = 1; r < s; r++) {
+        V = (V * V - Qk - Qk) % n;
+        if (V.neg) V += n;
+        if (V.isZero()) return true;
+        Qk = Qk * Qk % n;
+    }
+    return false;
+}
+
+// Baillie–PSW: strong base-2 Miller–Rabin followed by the strong Lucas test
+inline bool isProbablePrimeBPSW(const BigInt& n) {
+    if (n.neg) return false;
+    if (n.bitLength() <= 64) return isPrime(n.low());
+    return isProbablePrime(n, 1) && isStrongLucasProbablePrime(n);
+}
+
+// Primes up to `limit` as a sieve bitmap
+inline vector<bool> primeSieve(u64 limit) {
+    vector<bool> sieve(limit + 1, true);
+    sieve[0] = false;
+    if (limit >= 1) sieve[1] = false;
+    for (u64 i = 2; i * i <= limit; i++) {
+        if (sieve[i]) {
+            for (u64 j = i * i; j <= limit; j += i) sieve[j] = false;
+        }
+    }
+    return sieve;
+}
+
+// Odd primes below SIEVE_LIMIT (computed once)
+inline const vector<u64>& sievePrimes() {
+    static const vector<u64> primes = [] {
+        vector<bool> sieve = primeSieve(SIEVE_LIMIT);
+        vector<u64> list;
+        for (u64 p = 3; p < SIEVE_LIMIT; p += 2)
+            if (sieve[p]) list.push_back(p);
+        return list;
+    }();
+    return primes;
+}
+
+// Offsets i (start + 2i, i < SIEVE_WINDOW) with no odd prime factor below SIEVE_LIMIT.
+// start must be odd and larger than SIEVE_LIMIT.
+inline vector<int> sieveWindow(const BigInt& start) {
+    vector<char> composite(SIEVE_WINDOW, 0);
+    for (u64 p : sievePrimes()) {
+        u64 r = start.modU64(p);
+        // start + 2i == 0 (mod p)  <=>  i == -r / 2 (mod p)
+        u64 i = (p - r) % p * ((p + 1) / 2) % p;
+        for (; i < (u64)SIEVE_WINDOW; i += p) composite[i] = 1;
+    }
+    vector<int> survivors;
+    for (int i = 0; i < SIEVE_WINDOW; i++)
+        if (!composite[i]) survivors.push_back(i);
+    return survivors;
+}
+
+// Searches random windows until it finds a prime with exactly `bits` bits (top two bits set
+// for bits > 3) or `stop` becomes true; returns 0 when stopped. One worker's share of randomPrime.
+template <class RNG>
+BigInt searchPrime(int bits, RNG& rng, const atomic<bool>& stop) {
+    auto draw = [&] {
+        BigInt x = randomBits(bits, rng);
+        if (bits > 3 && !x.bit(bits - 2)) x += BigInt(1) << (bits - 2);
+        return x.isOdd() ? x : x + 1;
+    };
+    if (bits <= 32) {
+        // small sizes: test odd candidates directly
+        while (!stop) {
+            BigInt x = draw();
+            if (x.bitLength() == bits && isPrime(x.low())) return x;
+        }
+        return BigInt();
+    }
+    while (!stop) {
+        BigInt start = draw();
+        for (int i : sieveWindow(start)) {
+            if (stop) break;
+            BigInt x = start + BigInt(2LL * i);
+            if (x.bitLength() != bits) break;
+            if (isProbablePrimeBPSW(x)) return x;
+        }
+    }
+    return BigInt();
+}
+
+// Random prime with exactly `bits` bits (bits >= 3) on the calling thread
+template <class RNG>
+BigInt randomPrime(int bits, RNG& rng) {
+    if (bits < 3) throw invalid_argument("randomPrime needs at least 3 bits");
+    atomic<bool> never(false);
+    return searchPrime(bits, rng, never);
+}
+
+// Runs search(rng, stop, out) on every worker of the pool, each with its own RNG, until one
+// of them returns true; that worker's `out` is the result and `stop` tells the others to quit.
+template <class Result, class Search>
+Result raceWorkers(ThreadPool& pool, Search search) {
+    atomic<bool> found(false);
+    mutex m;
+    Result result{};
+    unsigned seed = random_device{}();
+    vector<future<void>> workers;
+    for (unsigned w = 0; w < pool.size(); w++) {
+        workers.push_back(pool.submit([&, w] {
+            mt19937_64 rng(seed + 0x9e3779b97f4a7c15ULL * (w + 1));
+            Result out{};
+            bool hit = search(rng, found, out);
+            lock_guard<mutex> lock(m);
+            if (hit && !found) {
+                result = out;
+                found = true;
+            }
+        }));
+    }
+    for (auto& f : workers) f.get();
+    return result;
+}
+
+// Random prime with exactly `bits` bits (bits >= 3), top two bits set for bits > 3.
+// Every worker of the pool searches its own random windows; the first prime found is returned.
+inline BigInt randomPrime(int bits, ThreadPool& pool) {
+    if (bits < 3) throw invalid_argument("randomPrime needs at least 3 bits");
+    return raceWorkers<BigInt>(pool, [bits](mt19937_64& rng, const atomic<bool>& stop, BigInt& p) {
+        p = searchPrime(bits, rng, stop);
+        return !p.isZero();
+    });
+}
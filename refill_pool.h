@@ -0,0 +1,214 @@
+/*
+    refill_pool.h — background-filled pool of precomputed items (low-water-mark refill)
+
+    Purpose:
+    - The shared core of RSAKeyPool (rsa_keypool.h) and RerandomizationPool
+        (elgamal_rerandomize.h): items that are expensive to make but independent
+        of the request are produced ahead of time on background threads into a
+        BoundedQueue (lock-free, thread_pool.h), and a caller pops one in O(1).
+
+    Refill policy:
+    - Producer threads sleep while the pool is healthy. When a take leaves
+        `lowWater` items or fewer, one refill round starts and the producers fill
+        the queue back to capacity, then go back to sleep (hysteresis, so the
+        threads do not wake up for every single item).
+    - The take path itself never takes a lock; only crossing the low-water mark
+        touches the mutex that wakes the producers.
+    - A producer reserves `block` queue slots per lock (1 for RSA keys, more for
+        cheap items), so several producers never overshoot the capacity.
+    - waitUntilFull() runs a round on demand and blocks until it completes.
+
+    Metrics (stats()):
+    - depth, hits / misses of the take path, items generated in the background
+    - refill rounds and their latency (low-water crossing -> queue full again),
+        last / mean / max; the initial fill from empty is reported on its own
+
+    Notes:
+    - make(rng) runs on the producers and, on a miss, on the taking thread, so it
+        must be safe to call concurrently. An owner whose make uses its own members
+        declares the RefillPool after them (it is built last, destroyed first).
+*/
+
+#pragma once
+
+#include "thread_pool.h"
+
+struct RefillStats {
+    size_t depth = 0;          // items ready in the queue
+    u64 hits = 0;              // takes served from the queue
+    u64 misses = 0;            // takes that found it empty and made the item inline
+    u64 generated = 0;         // items produced by the background threads
+    u64 refills = 0;           // refill rounds (low-water mark or waitUntilFull)
+    double initialFillMs = 0;  // construction -> queue full (0 while still filling)
+    double lastRefillMs = 0;   // low-water crossing -> queue full, most recent round
+    double meanRefillMs = 0;
+    double maxRefillMs = 0;
+};
+
+template <class T>
+class RefillPool {
+public:
+    typedef function<T(mt19937_64&)> Make;
+
+    RefillPool(Make make, size_t capacity, size_t lowWater, unsigned threads = 1, size_t block = 1)
+        : make(move(make)), lowWater(lowWater), block(max<size_t>(1, block)), queue(capacity) {
+        refilling = true;   // start by filling the whole pool
+        refillStart = chrono::steady_clock::now();
+        unsigned seed = random_device{}();
+        for (unsigned i = 0; i < max(1u, threads); i++)
+            producers.emplace_back([this, i, seed] { producerLoop(seed + 0x9e3779b97f4a7c15ULL * (i + 1)); });
+    }
+
+    ~RefillPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : producers) t.join();
+    }
+
+    RefillPool(const RefillPool&) = delete;
+    RefillPool& operator=(const RefillPool&) = delete;
+
+    // Non-blocking: false when no item is ready (counted as a miss)
+    bool tryTake(T& item) {
+        bool hit = queue.tryPop(item);
+        (hit ? hits : misses)++;
+        if (queue.size() <= lowWater) requestRefill();
+        return hit;
+    }
+
+    // Always returns an item: from the queue when one is ready, made on this thread otherwise
+    T take() {
+        T item;
+        if (tryTake(item)) return item;
+        static thread_local mt19937_64 rng(random_device{}());
+        return make(rng);
+    }
+
+    // take() for n items at once, with one depth check and one update of the counters
+    void take(T* out, size_t n) {
+        static thread_local mt19937_64 rng(random_device{}());
+        u64 hit = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (queue.tryPop(out[i])) hit++;
+            else out[i] = make(rng);
+        }
+        hits += hit;
+        misses += n - hit;
+        if (queue.size() <= lowWater) requestRefill();
+    }
+
+    // Tops the pool up to capacity and blocks until it is full
+    void waitUntilFull() {
+        unique_lock<mutex> lock(m);
+        if (!refilling && queue.size() < queue.capacity()) startRound();
+        cv.notify_all();
+        cv.wait(lock, [this] { return stopping || !refilling.load(); });
+    }
+
+    size_t available() const { return queue.size(); }
+    size_t capacity() const { return queue.capacity(); }
+
+    RefillStats stats() const {
+        RefillStats s;
+        s.depth = queue.size();
+        s.hits = hits;
+        s.misses = misses;
+        s.generated = generated;
+        s.refills = refills;
+        lock_guard<mutex> lock(m);
+        s.initialFillMs = initialFillMs;
+        s.lastRefillMs = lastRefillMs;
+        s.meanRefillMs = completedRounds ? totalRefillMs / completedRounds : 0;
+        s.maxRefillMs = maxRefillMs;
+        return s;
+    }
+
+private:
+    Make make;
+    size_t lowWater, block;
+    BoundedQueue<T> queue;
+    atomic<u64> hits{0}, misses{0}, generated{0}, refills{0};
+    size_t inFlight = 0;   // reserved queue slots being filled right now, guarded by m
+
+    vector<thread> producers;
+    mutable mutex m;
+    condition_variable cv;
+    atomic<bool> refilling{false};   // written under m, read lock-free by the take path
+    bool stopping = false;           // guarded by m
+    chrono::steady_clock::time_point refillStart;                   // guarded by m
+    bool initialFill = true;                                        // guarded by m
+    double initialFillMs = 0;                                       // guarded by m
+    double lastRefillMs = 0, totalRefillMs = 0, maxRefillMs = 0;   // guarded by m
+    u64 completedRounds = 0;                                        // guarded by m
+
+    // Called under m
+    void startRound() {
+        refilling = true;
+        refillStart = chrono::steady_clock::now();
+        refills++;
+    }
+
+    void requestRefill() {
+        if (refilling.load(memory_order_acquire)) return;   // round already running: no lock
+        {
+            lock_guard<mutex> lock(m);
+            if (refilling) return;
+            startRound();
+        }
+        cv.notify_all();
+    }
+
+    // Called under m when the queue is full again
+    void finishRound() {
+        refilling = false;
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - refillStart).count();
+        if (initialFill) {
+            initialFill = false;
+            initialFillMs = ms;
+            return;
+        }
+        lastRefillMs = ms;
+        totalRefillMs += ms;
+        maxRefillMs = max(maxRefillMs, ms);
+        completedRounds++;
+    }
+
+    void producerLoop(u64 seed) {
+        mt19937_64 rng(seed);
+        vector<T> items;
+        while (true) {
+            size_t want;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [this] { return stopping || refilling.load(); });
+                if (stopping) return;
+                // reserve slots so several producers do not overshoot the capacity
+                size_t used = queue.size() + inFlight;
+                if (used >= queue.capacity()) {
+                    if (inFlight == 0) {
+                        finishRound();
+                        cv.notify_all();   // wake waitUntilFull()
+                    } else {
+                        cv.wait(lock, [this] { return stopping || inFlight == 0; });
+                    }
+                    continue;
+                }
+                want = min(block, queue.capacity() - used);
+                inFlight += want;
+            }
+            items.clear();
+            for (size_t i = 0; i < want; i++) items.push_back(make(rng));
+            size_t pushed = 0;
+            for (T& item : items) pushed += queue.tryPush(item);
+            {
+                lock_guard<mutex> lock(m);
+                inFlight -= want;
+                generated += pushed;
+            }
+            cv.notify_all();
+        }
+    }
+};
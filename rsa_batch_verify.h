@@ -0,0 +1,317 @@
+/*
+    rsa_batch_verify.h — batch verification of textbook RSA signatures under one key
+
+    Purpose:
+    - Checking N signatures one by one costs N exponentiations S_i^e. When they
+        all share (n, e), one randomized product test can vouch for the whole
+        batch, and only a failing batch needs a closer look.
+
+    Small-exponent test (Bellare–Garay–Rabin):
+    - Pick random r_i, uniform in [1, 2^screenBits), and check
+            (prod S_i^{r_i})^e == prod M_i^{r_i}   (mod n)
+    - Valid signatures always pass. Without the r_i a forger could multiply one
+        signature by c and another by c^{-1} and keep the product; with them a
+        bad signature whose error S_i^e / M_i has large order gets through with
+        probability about 2^-screenBits.
+    - Elements of small order are the gap (Boyd–Pavlovski): -1 is known to
+        everyone, and negating two signatures passes one round whenever r_i and
+        r_j have the same parity, i.e. with probability 1/2 whatever screenBits is.
+        So the screen is followed by screenBits random-subset rounds (r_i in
+        {0, 1}): any bad batch fails each of them with probability at least 1/2,
+        and the whole screen passes a bad batch with probability below 2^-screenBits.
+    - The products are multi-exponentiations with short exponents, computed
+        with Pippenger's bucket method: per window of w exponent bits every item
+        costs one multiplication into its bucket, plus 2 * 2^w per window to
+        combine the buckets. A clean batch costs about 2 * screenBits / w + screenBits
+        multiplications per item (the subset rounds are one multiplication per
+        item each). That beats one S_i^e per item only for long e, so verify()
+        checks every signature directly (batchPower) when e has at most
+        2 * screenBits bits, which covers e = 65537.
+
+    Finding the bad items:
+    - A failing range is split in half and each half is screened again
+        (if the left half passes, the right half is known to fail and goes
+        straight to splitting). Ranges of VERIFY_LEAF items or fewer are checked
+        one by one with batchPower (simd_modexp.h). The bisection itself is
+        bisectFailures, shared with the ElGamal batch verifier (elgamal_verify.h).
+    - With b bad signatures this costs about b * log2(N / b) extra screens.
+
+    Notes:
+    - A batch pass is probabilistic (error below 2^-screenBits), not a proof that
+        every S_i was checked. Textbook RSA without padding has bigger problems.
+    - r_i come from std::mt19937_64 seeded from std::random_device (demo grade).
+*/
+
+#pragma once
+
+#include "simd_modexp.h"
+#include "thread_pool.h"
+
+const size_t VERIFY_LEAF = 8;   // ranges this small are verified one signature at a time
+
+struct BatchVerifyResult {
+    bool ok = true;              // every signature in the batch is valid
+    vector<size_t> failures;     // indices of the invalid signatures, ascending
+    int screens = 0;             // product tests run (1 for a clean batch, 0 when checked one by one)
+};
+
+// Window width minimising (bits / w) * (items + 2 * 2^w) multiplications
+inline int pippengerWindow(size_t items, int bits) {
+    int w = 1;
+    double best = 1e300;
+    for (int c = 1; c <= 16; c++) {
+        double cost = (double)((bits + c - 1) / c) * (items + 2.0 * (1 << c));
+        if (cost < best) best = cost, w = c;
+    }
+    return w;
+}
+
+// prod xs[i]^{r[i]} in Montgomery form, r[i] < 2^bits (Pippenger buckets, windows of w bits)
+inline vector<u64> multiPow(const BigMontgomery& mont, const vector<const vector<u64>*>& xs, const vector<u64>& r, int bits) {
+    size_t count = xs.size();
+    int w = pippengerWindow(count, bits);
+    vector<u64> acc = mont.one, tmp;
+    vector<vector<u64>> bucket(1 << w);
+    vector<char> used(1 << w);
+    bool started = false;
+    for (int lo = (bits - 1) / w * w; lo >= 0; lo -= w) {
+        if (started)
+            for (int s = 0; s < w; s++) mont.sqrInto(acc, acc);
+        fill(used.begin(), used.end(), 0);
+        for (size_t i = 0; i < count; i++) {
+            u64 v = (r[i] >> lo) & ((1ULL << w) - 1);
+            if (!v) continue;
+            if (used[v]) mont.mulInto(bucket[v], bucket[v], *xs[i]);
+            else bucket[v] = *xs[i], used[v] = 1;
+        }
+        // sum of v * bucket[v] (multiplicatively): running product from the top bucket down
+        vector<u64> run, total;
+        bool haveRun = false, haveTotal = false;
+        for (int v = (1 << w) - 1; v >= 1; v--) {
+            if (used[v]) {
+                if (haveRun) mont.mulInto(run, run, bucket[v]);
+                else run = bucket[v], haveRun = true;
+            }
+            if (!haveRun) continue;
+            if (haveTotal) mont.mulInto(total, total, run);
+            else total = run, haveTotal = true;
+        }
+        if (haveTotal) {
+            mont.mulInto(tmp, acc, total);
+            swap(acc, tmp);
+            started = true;
+        }
+    }
+    return acc;
+}
+
+// prod xs[i]^{r[i]} mod n as a plain number, with item i in SIMD lane i % lanes. xs[i] holds the
+// k Montgomery-form digits of one item. Every lane keeps its own buckets; a group of `lanes`
+// items is one vector multiplication (each lane's bucket gathered into A, the result scattered
+// back), and the per-lane products are multiplied together at the end.
+inline BigInt multiPowLanes(const SimdMontgomery& ctx, const vector<const vector<u64>*>& xs, const vector<u64>& r,
+                            int bits) {
+    int L = ctx.lanes, k = ctx.k;
+    size_t groups = (xs.size() + L - 1) / L;
+    int w = pippengerWindow(groups, bits);
+    u64 mask = (1ULL << w) - 1;
+    vector<vector<u64>> item(groups, vector<u64>(k * L, 0));
+    vector<u64> rv(groups * L, 0);
+    for (size_t i = 0; i < xs.size(); i++) {
+        for (int j = 0; j < k; j++) item[i / L][j * L + i % L] = (*xs[i])[j];
+        rv[i] = r[i];
+    }
+    vector<u64> acc = ctx.one, a(k * L), c, run, total;
+    vector<vector<u64>> bucket(1 << w);
+    vector<u64> vals(L);
+    bool started = false;
+    for (int lo = (bits - 1) / w * w; lo >= 0; lo -= w) {
+        if (started)
+            for (int s = 0; s < w; s++) ctx.sqrInto(acc, acc);
+        for (auto& b : bucket) b = ctx.one;
+        for (size_t g = 0; g < groups; g++) {
+            bool any = false;
+            for (int l = 0; l < L; l++) any |= (vals[l] = (rv[g * L + l] >> lo) & mask) != 0;
+            if (!any) continue;
+            for (int l = 0; l < L; l++)
+                for (int j = 0; j < k; j++) a[j * L + l] = bucket[vals[l]][j * L + l];
+            ctx.mulInto(c, a, item[g]);
+            for (int l = 0; l < L; l++)
+                if (vals[l])
+                    for (int j = 0; j < k; j++) bucket[vals[l]][j * L + l] = c[j * L + l];
+        }
+        run = total = ctx.one;
+        for (int v = (int)mask; v >= 1; v--) {
+            ctx.mulInto(run, run, bucket[v]);
+            ctx.mulInto(total, total, run);
+        }
+        ctx.mulInto(acc, acc, total);
+        started = true;
+    }
+    vector<BigInt> parts(L);
+    ctx.fromMont(acc, parts, 0, L);
+    BigInt res = parts[0];
+    for (int l = 1; l < L; l++) res = res * parts[l] % ctx.mod;
+    return res;
+}
+
+// Appends the bad items of idx to `failures` and returns the number of screens run. screen(sub, rng) is a
+// randomized batch test (true: every item of sub is valid); leaf(sub, failures) checks leafSize items or
+// fewer one at a time. A failing range is split in half and the halves screened again; if the left half
+// is clean the right one is known to fail and goes straight to splitting. knownBad: the caller already
+// knows idx contains a failure.
+template <class Screen, class Leaf>
+int bisectFailures(const vector<size_t>& idx, bool knownBad, size_t leafSize, Screen& screen, Leaf& leaf, mt19937_64& rng,
+                   vector<size_t>& failures) {
+    if (idx.empty()) return 0;
+    if (idx.size() <= leafSize) {
+        leaf(idx, failures);
+        return 0;
+    }
+    int screens = 0;
+    if (!knownBad && (screens++, screen(idx, rng))) return screens;
+    size_t half = idx.size() / 2;
+    vector<size_t> left(idx.begin(), idx.begin() + half), right(idx.begin() + half, idx.end());
+    size_t before = failures.size();
+    bool leftBad = left.size() <= leafSize || (screens++, !screen(left, rng));
+    if (leftBad) screens += bisectFailures(left, true, leafSize, screen, leaf, rng, failures);
+    bool leftFound = failures.size() > before;
+    screens += bisectFailures(right, !leftFound, leafSize, screen, leaf, rng, failures);   // the whole range failed
+    return screens;
+}
+
+// bisectFailures on a pool: idx is cut into one part per worker (of more than leafSize items), and every
+// part is screened and bisected on its own task with its own generator, seeded from rng. The failures
+// of all parts are appended in part order.
+template <class Screen, class Leaf>
+int bisectFailures(ThreadPool& pool, const vector<size_t>& idx, size_t leafSize, Screen& screen, Leaf& leaf, mt19937_64& rng,
+                   vector<size_t>& failures) {
+    size_t parts = max<size_t>(1, min<size_t>(pool.size(), idx.size() / (leafSize + 1)));
+    vector<u64> seeds(parts);
+    for (u64& seed : seeds) seed = rng();
+    vector<vector<size_t>> found(parts);
+    vector<int> screens(parts, 0);
+    parallelFor(pool, (long long)parts, [&](long long t) {
+        vector<size_t> part(idx.begin() + idx.size() * t / parts, idx.begin() + idx.size() * (t + 1) / parts);
+        mt19937_64 partRng(seeds[t]);
+        screens[t] = bisectFailures(part, false, leafSize, screen, leaf, partRng, found[t]);
+    });
+    for (const vector<size_t>& f : found) failures.insert(failures.end(), f.begin(), f.end());
+    return accumulate(screens.begin(), screens.end(), 0);
+}
+
+class BatchVerifier {
+public:
+    BatchVerifier(const BigInt& n, const BigInt& e, int screenBits = 32, SimdLevel level = detectSimd())
+        : n(n), e(e), mont(n), level(level), screenBits(max(1, min(screenBits, 64))), rng(random_device{}()) {
+        if (level != SimdLevel::Scalar && n.isOdd()) simd.reset(new SimdMontgomery(n, level));
+    }
+
+    // Verifies S_i^e == M_i (mod n) for all i
+    BatchVerifyResult verify(const vector<BigInt>& msgs, const vector<BigInt>& sigs) {
+        if (msgs.size() != sigs.size()) throw invalid_argument("batch verify needs one signature per message");
+        BatchVerifyResult res;
+        this->msgs = &msgs;
+        this->sigs = &sigs;
+        vector<size_t> idx;
+        for (size_t i = 0; i < msgs.size(); i++) {
+            if (msgs[i].neg || sigs[i].neg || msgs[i] >= n || sigs[i] >= n) {
+                res.failures.push_back(i);   // out of range: not a signature for this key
+                continue;
+            }
+            idx.push_back(i);
+        }
+        if (e.bitLength() <= 2 * screenBits) {
+            checkEach(idx, res.failures);   // short e: S_i^e one by one is cheaper than a sound screen
+        } else {
+            toMontgomery(sigs, idx, monS);
+            toMontgomery(msgs, idx, monM);
+            check(idx, res);
+        }
+        sort(res.failures.begin(), res.failures.end());
+        res.ok = res.failures.empty();
+        return res;
+    }
+
+private:
+    BigInt n, e;
+    BigMontgomery mont;
+    SimdLevel level;
+    unique_ptr<SimdMontgomery> simd;   // lane kernels when the CPU has them
+    int screenBits;
+    mt19937_64 rng;
+    const vector<BigInt>* msgs = nullptr;
+    const vector<BigInt>* sigs = nullptr;
+    vector<vector<u64>> monM, monS;   // Montgomery forms (SIMD digits or 64-bit limbs)
+
+    void toMontgomery(const vector<BigInt>& xs, const vector<size_t>& idx, vector<vector<u64>>& out) {
+        out.assign(xs.size(), {});
+        if (!simd) {
+            for (size_t i : idx) out[i] = mont.toMont(xs[i]);
+            return;
+        }
+        int L = simd->lanes, k = simd->k;
+        vector<BigInt> group;
+        for (size_t off = 0; off < idx.size(); off += L) {
+            group.clear();
+            for (size_t j = off; j < idx.size() && j < off + L; j++) group.push_back(xs[idx[j]]);
+            vector<u64> v = simd->toMont(simd->load(group, 0));
+            for (size_t l = 0; l < group.size(); l++) {
+                vector<u64>& d = out[idx[off + l]];
+                d.resize(k);
+                for (int j = 0; j < k; j++) d[j] = v[j * L + l];
+            }
+        }
+    }
+
+    // S_i^e == M_i for every item, SIMD-batched
+    void checkEach(const vector<size_t>& idx, vector<size_t>& failures) const {
+        vector<BigInt> s;
+        for (size_t i : idx) s.push_back((*sigs)[i]);
+        vector<BigInt> v = batchPower(s, e, n, level);
+        for (size_t j = 0; j < idx.size(); j++)
+            if (v[j] != (*msgs)[idx[j]]) failures.push_back(idx[j]);
+    }
+
+    // Product test over the given items, repeated until a batch with a bad item passes with probability
+    // below 2^-screenBits: one round with long r_i, then screenBits random-subset rounds. Stops at the
+    // first failing round.
+    bool screen(const vector<size_t>& idx, mt19937_64& rng) const {
+        for (int round = 0; round <= screenBits; round++)
+            if (!screenRound(idx, rng, round == 0 ? screenBits : 1)) return false;
+        return true;
+    }
+
+    // One product test, r_i uniform in [1, 2^bits), or in {0, 1} (a random subset) for bits == 1
+    bool screenRound(const vector<size_t>& idx, mt19937_64& rng, int bits) const {
+        vector<const vector<u64>*> xs, ys;
+        vector<u64> r;
+        u64 mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+        for (size_t i : idx) {
+            u64 v = rng() & mask;
+            while (bits > 1 && v == 0) v = rng() & mask;
+            if (!v) continue;   // left out of this subset
+            xs.push_back(&monS[i]);
+            ys.push_back(&monM[i]);
+            r.push_back(v);
+        }
+        if (xs.empty()) return true;
+        if (simd) return power(multiPowLanes(*simd, xs, r, bits), e, n) == multiPowLanes(*simd, ys, r, bits);
+        vector<u64> left = multiPow(mont, xs, r, bits), right = multiPow(mont, ys, r, bits);
+        left = slidingWindowPow(mont, left, e.bitLength(), [this](int i) { return e.bit(i); });
+        return mont.fromMont(left) == mont.fromMont(right);
+    }
+
+    void check(const vector<size_t>& idx, BatchVerifyResult& res) {
+        auto screenFn = [this](const vector<size_t>& sub, mt19937_64& g) { return screen(sub, g); };
+        auto leaf = [this](const vector<size_t>& sub, vector<size_t>& failures) { checkEach(sub, failures); };
+        res.screens += bisectFailures(idx, false, VERIFY_LEAF, screenFn, leaf, rng, res.failures);
+    }
+};
+
+// One-shot form: verifies all (M_i, S_i) under (n, e)
+inline BatchVerifyResult batchVerify(const vector<BigInt>& msgs, const vector<BigInt>& sigs, const BigInt& n,
+                                     const BigInt& e, int screenBits = 32) {
+    BatchVerifier verifier(n, e, screenBits);
+    return verifier.verify(msgs, sigs);
+}
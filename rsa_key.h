@@ -0,0 +1,185 @@
+/*
+    rsa_key.h — RSA private key with CRT-accelerated private operations
+
+    Purpose:
+    - The demos used to decrypt / sign with power(C, d, n) even though p and q
+        were sitting in main. With the factors known, the private operation can be
+        split into smaller exponentiations (Chinese Remainder Theorem).
+    - Supports multi-prime keys, n = r_0 * r_1 * ... * r_{k-1} (RFC 8017 style).
+
+    Precomputed once per key, for every prime r_i (a CRT "leg"):
+    - exp_i   = d mod (r_i - 1)            (dP, dQ for a two-prime key)
+    - coeff_i = (r_0 * ... * r_{i-1})^{-1} mod r_i   (qInv-like Garner coefficient)
+    - a Montgomery context for r_i (so no per-operation setup)
+
+    Private operation (decrypt / sign), Garner recombination:
+        m_i = c^exp_i mod r_i               (one leg per prime)
+        m = m_0, R = r_0
+        for i >= 1:  h = coeff_i * (m_i - m) mod r_i;  m += R * h;  R *= r_i
+
+    Why it is faster:
+    - Modexp cost grows roughly with the cube of the operand size, so two
+        exponentiations at half size cost about 1/4 of one full-size one, and
+        k legs at 1/k size cost about 1/k^2.
+    - The legs are independent, so for k >= 2 they can run on separate cores
+        (legPool); only the cheap recombination is sequential.
+    - privateOpBatch runs each leg over a whole batch of inputs at once with
+        batchPower (simd_modexp.h): every input shares the leg's prime and exponent,
+        so 4-8 of them go through the SIMD lanes together.
+
+    Notes:
+    - A key is read-only after construction and can be shared between threads.
+    - Legs run one after the other by default. Under load (batches, servers) the
+        cores are better spent on separate operations than on one operation's
+        legs; legPool is for single operations on an otherwise idle machine. Its
+        tasks must not themselves call privateOp through the same pool.
+    - Educational code: no blinding, no fault-attack check on the CRT result.
+*/
+
+#pragma once
+
+#include "simd_modexp.h"
+#include "thread_pool.h"
+
+// One CRT component of a private key
+struct CRTLeg {
+    BigInt r;       // prime factor r_i
+    BigInt exp;     // d mod (r_i - 1)
+    BigInt coeff;   // (r_0 * ... * r_{i-1})^{-1} mod r_i (unused for i = 0)
+    shared_ptr<BigMontgomery> mont;
+};
+
+struct RSAPrivateKey {
+    BigInt n, e, d;
+    vector<CRTLeg> legs;
+    ThreadPool* legPool = nullptr;   // when set, legs 1..k-1 of privateOp run on this pool
+    bool constantTime = false;  // fixed-window exponentiation for the secret leg exponents
+
+    RSAPrivateKey() {}
+
+    // Two-prime key from distinct odd primes p, q and e with gcd(e, phi) == 1
+    RSAPrivateKey(const BigInt& p, const BigInt& q, const BigInt& e_) : RSAPrivateKey(vector<BigInt>{p, q}, e_) {}
+
+    // Multi-prime key: distinct odd primes, e with gcd(e, phi) == 1
+    RSAPrivateKey(const vector<BigInt>& primes, const BigInt& e_) : e(e_) {
+        if (primes.size() < 2) throw invalid_argument("RSA key needs at least two primes");
+        n = 1;
+        BigInt phi = 1;
+        for (const BigInt& r : primes) {
+            n *= r;
+            phi *= r - 1;
+        }
+        d = modInverse(e, phi);
+
+        BigInt R = 1;
+        for (const BigInt& r : primes) {
+            CRTLeg leg;
+            leg.r = r;
+            leg.exp = d % (r - 1);
+            leg.coeff = legs.empty() ? BigInt(0) : modInverse(R % r, r);
+            leg.mont = make_shared<BigMontgomery>(r);
+            legs.push_back(leg);
+            R *= r;
+        }
+    }
+
+    int primeCount() const { return (int)legs.size(); }
+
+    // m_i = c^exp_i mod r_i
+    BigInt leg(int i, const BigInt& c) const {
+        const CRTLeg& L = legs[i];
+        return constantTime ? L.mont->powConstTime(c % L.r, L.exp) : L.mont->pow(c % L.r, L.exp);
+    }
+
+    // c^d mod n via one exponentiation per prime and Garner recombination
+    BigInt privateOp(const BigInt& c) const {
+        int k = primeCount();
+        vector<BigInt> m(k);
+        if (legPool && legPool->size() > 1) {
+            vector<future<BigInt>> pending;
+            for (int i = 1; i < k; i++) pending.push_back(legPool->submit([this, i, &c] { return leg(i, c); }));
+            m[0] = leg(0, c);
+            for (int i = 1; i < k; i++) m[i] = pending[i - 1].get();
+        } else {
+            for (int i = 0; i < k; i++) m[i] = leg(i, c);
+        }
+        return combine(m);
+    }
+
+    // privateOp for every input, legs computed as SIMD batches (sliding window, so
+    // constant-time keys take the one-at-a-time path)
+    vector<BigInt> privateOpBatch(const vector<BigInt>& cs) const {
+        vector<BigInt> res(cs.size());
+        if (constantTime) {
+            for (size_t j = 0; j < cs.size(); j++) res[j] = privateOp(cs[j]);
+            return res;
+        }
+        int k = primeCount();
+        vector<vector<BigInt>> m(k);
+        for (int i = 0; i < k; i++) m[i] = batchPower(cs, legs[i].exp, legs[i].r);
+        vector<BigInt> parts(k);
+        for (size_t j = 0; j < cs.size(); j++) {
+            for (int i = 0; i < k; i++) parts[i] = move(m[i][j]);
+            res[j] = combine(parts);
+        }
+        return res;
+    }
+
+    // Garner recombination of the leg results m_i = x mod r_i into x mod n
+    BigInt combine(const vector<BigInt>& m) const {
+        int k = primeCount();
+        BigInt res = m[0], R = legs[0].r;
+        for (int i = 1; i < k; i++) {
+            const BigInt& r = legs[i].r;
+            BigInt h = (m[i] - res) % r;
+            if (h.neg) h += r;
+            h = legs[i].coeff * h % r;
+            res += R * h;
+            R *= r;
+        }
+        return res;
+    }
+
+    BigInt decrypt(const BigInt& c) const { return privateOp(c); }
+    BigInt sign(const BigInt& m) const { return privateOp(m); }
+};
+
+// Key file as written by `RSA_batch keygen`: "name value" lines (n, e, one "prime" line per
+// prime), '#' comments. A public key file has just n and e.
+struct RSAKeyFile {
+    BigInt n, e;
+    vector<BigInt> primes;
+};
+
+inline bool loadRSAKeyFile(const string& path, RSAKeyFile& key) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "cannot open key file " << path << "\n";
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string name, value;
+        if (!(fields >> name >> value) || name[0] == '#') continue;
+        BigInt v;
+        try {
+            v = BigInt::fromString(value);
+        } catch (const invalid_argument&) {
+            cerr << "bad number for " << name << " in " << path << "\n";
+            return false;
+        }
+        if (name == "n") key.n = v;
+        else if (name == "e") key.e = v;
+        else if (name == "prime") key.primes.push_back(v);
+    }
+    if (key.n.isZero() && !key.primes.empty()) {
+        key.n = 1;
+        for (const BigInt& p : key.primes) key.n *= p;
+    }
+    if (key.n < BigInt(3) || key.e.isZero()) {
+        cerr << "key file needs n (or primes) and e\n";
+        return false;
+    }
+    return true;
+}
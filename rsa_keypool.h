@@ -0,0 +1,80 @@
+/*
+    rsa_keypool.h — background pool of ready-to-use RSA key pairs
+
+    Purpose:
+    - Generating a key (two random primes, e from the gcd loop, d = modInverse,
+        CRT legs) costs tens to hundreds of milliseconds. When a service hands
+        out a fresh key per request, that cost lands on the request path.
+    - RSAKeyPool moves it to background threads: keys are generated ahead of
+        time into a BoundedQueue (lock-free, thread_pool.h), and a caller just
+        pops one in O(1).
+
+    Refill policy (RefillPool, refill_pool.h):
+    - Producer threads sleep while the pool is healthy. When a fetch leaves
+        `lowWater` keys or fewer, one refill round starts and the producers fill
+        the queue back to capacity, then go back to sleep. The fetch path itself
+        never takes a lock.
+
+    API:
+    - tryAcquire(key): non-blocking; false on an empty pool (counted as a miss)
+    - acquire(): pops a key, or generates one inline on a miss
+    - stats(): hits, misses, keys generated in the background, refill rounds
+
+    Notes:
+    - Same non-cryptographic RNG caveat as primes.h.
+*/
+
+#pragma once
+
+#include "primes.h"
+#include "refill_pool.h"
+#include "rsa_key.h"
+
+// Fresh two-prime key with a `bits`-bit modulus; e is the first odd value from 65537 up coprime to phi
+template <class RNG>
+RSAPrivateKey generateRSAKey(int bits, RNG& rng) {
+    BigInt p = randomPrime(bits / 2, rng), q;
+    do {
+        q = randomPrime(bits - bits / 2, rng);
+    } while (q == p);
+    BigInt phi = (p - 1) * (q - 1);
+    BigInt e = 65537;
+    while (gcd(e, phi) != BigInt(1)) e += 2;
+    return RSAPrivateKey(p, q, e);
+}
+
+struct KeyPoolStats {
+    u64 hits = 0;        // fetches served from the queue
+    u64 misses = 0;      // fetches that found the queue empty
+    u64 generated = 0;   // keys produced by the background threads
+    u64 refills = 0;     // times the low-water mark started a refill round
+};
+
+class RSAKeyPool {
+public:
+    RSAKeyPool(int bits, size_t capacity = 16, size_t lowWater = 4, unsigned threads = 1)
+        : bits(bits), pool([this](mt19937_64& rng) { return generateRSAKey(this->bits, rng); }, capacity, lowWater, threads) {}
+
+    // Non-blocking fetch: false when no key is ready
+    bool tryAcquire(RSAPrivateKey& key) { return pool.tryTake(key); }
+
+    // Always returns a key: from the pool when one is ready, generated on this thread otherwise
+    RSAPrivateKey acquire() { return pool.take(); }
+
+    size_t available() const { return pool.available(); }
+    size_t capacity() const { return pool.capacity(); }
+
+    KeyPoolStats stats() const {
+        RefillStats r = pool.stats();
+        KeyPoolStats s;
+        s.hits = r.hits;
+        s.misses = r.misses;
+        s.generated = r.generated;
+        s.refills = r.refills;
+        return s;
+    }
+
+private:
+    int bits;
+    RefillPool<RSAPrivateKey> pool;   // last: its producers call generateRSAKey with `bits`
+};
@@ -0,0 +1,254 @@
+/*
+    simd_modexp.h — multi-lane SIMD modular exponentiation for batch RSA
+
+    Purpose:
+    - Encrypting (or verifying) many messages under one key runs the same
+        exponentiation, with the same modulus and exponent, on different bases.
+        batchPower packs independent bases into the lanes of a vector register
+        and runs all of them through one instruction stream: 8 lanes with
+        AVX-512 IFMA, 4 lanes with AVX2.
+
+    Representation:
+    - Numbers are split into k digits of `radix` bits (52 for IFMA, 26 for AVX2),
+        each digit in its own 64-bit lane slot, and stored lane-interleaved:
+        digit j of lane l lives at v[j * lanes + l].
+    - IFMA: vpmadd52luq / vpmadd52huq add the low / high 52 bits of a 52x52-bit
+        product to a 64-bit accumulator.
+    - AVX2: vpmuludq gives the full 52-bit product of two 26-bit digits.
+    - Either way the accumulators have ~12 spare bits, so carries are only
+        propagated once, at the end of each Montgomery product.
+
+    Montgomery product (word-by-word, R = 2^(radix * k) > 4n):
+        for i in 0..k-1:
+            acc += a * b_i * 2^(radix*i);   m = acc_i * (-n^{-1}) mod 2^radix
+            acc += m * n * 2^(radix*i)      (digit i becomes 0; its carry moves up)
+        result = acc / R, kept in [0, 2n) without a final subtraction
+        ("almost Montgomery"), which is fine as input to the next product.
+
+    Dispatch:
+    - detectSimd() asks the CPU at runtime (__builtin_cpu_supports). The kernels
+        carry target attributes, so this header builds without -mavx flags and
+        the binary still runs on CPUs without AVX2 (scalar BigMontgomery path).
+    - The exponent is scanned with the sliding-window engine from modarith.h;
+        every lane follows the same window sequence.
+*/
+
+#pragma once
+
+#include <immintrin.h>
+#include "bignum.h"
+
+enum class SimdLevel { Scalar, AVX2, IFMA };
+
+inline SimdLevel detectSimd() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma")) return SimdLevel::IFMA;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    return SimdLevel::Scalar;
+}
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::IFMA: return "AVX-512 IFMA (8 lanes x 52-bit digits)";
+        case SimdLevel::AVX2: return "AVX2 (4 lanes x 26-bit digits)";
+        default: return "scalar";
+    }
+}
+
+// ---- kernels: out = a * b * R^{-1} mod n (in [0, 2n)) for every lane ----
+// a, b, out: k digits x lanes, interleaved; n: k digits (same modulus in every lane);
+// scratch: (2k + 1) x lanes words. out may alias a or b (it is written last).
+
+__attribute__((target("avx512f,avx512ifma")))
+inline void montMulIFMA(u64* out, const u64* a, const u64* b, const u64* n, u64 n0, int k, u64* scratch) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i mask = _mm512_set1_epi64((1ULL << 52) - 1);
+    const __m512i n0v = _mm512_set1_epi64(n0);
+    for (int t = 0; t <= 2 * k; t++) _mm512_storeu_si512(scratch + 8 * t, zero);
+
+    for (int i = 0; i < k; i++) {
+        __m512i bi = _mm512_loadu_si512(b + 8 * i);
+        __m512i cur = _mm512_loadu_si512(scratch + 8 * i);
+        __m512i t0 = _mm512_madd52lo_epu64(cur, _mm512_loadu_si512(a), bi);
+        __m512i m = _mm512_madd52lo_epu64(zero, _mm512_and_si512(t0, mask), n0v);
+        for (int j = 0; j < k; j++) {
+            __m512i aj = _mm512_loadu_si512(a + 8 * j);
+            __m512i nj = _mm512_set1_epi64(n[j]);
+            cur = _mm512_madd52lo_epu64(cur, aj, bi);
+            cur = _mm512_madd52lo_epu64(cur, m, nj);
+            __m512i next = _mm512_loadu_si512(scratch + 8 * (i + j + 1));
+            next = _mm512_madd52hi_epu64(next, aj, bi);
+            next = _mm512_madd52hi_epu64(next, m, nj);
+            if (j == 0) next = _mm512_add_epi64(next, _mm512_maskz_srli_epi64(0xFF, cur, 52));   // digit i is now 0 mod 2^52
+            else _mm512_storeu_si512(scratch + 8 * (i + j), cur);
+            cur = next;
+        }
+        _mm512_storeu_si512(scratch + 8 * (i + k), cur);
+    }
+    __m512i carry = zero;
+    for (int t = 0; t < k; t++) {
+        __m512i v = _mm512_add_epi64(_mm512_loadu_si512(scratch + 8 * (k + t)), carry);
+        _mm512_storeu_si512(out + 8 * t, _mm512_and_si512(v, mask));
+        carry = _mm512_maskz_srli_epi64(0xFF, v, 52);
+    }
+}
+
+__attribute__((target("avx2")))
+inline void montMulAVX2(u64* out, const u64* a, const u64* b, const u64* n, u64 n0, int k, u64* scratch) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask = _mm256_set1_epi64x((1LL << 26) - 1);
+    const __m256i n0v = _mm256_set1_epi64x((long long)n0);
+    for (int t = 0; t <= 2 * k; t++) _mm256_storeu_si256((__m256i*)(scratch + 4 * t), zero);
+
+    for (int i = 0; i < k; i++) {
+        __m256i bi = _mm256_loadu_si256((const __m256i*)(b + 4 * i));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(scratch + 4 * i));
+        s = _mm256_add_epi64(s, _mm256_mul_epu32(_mm256_loadu_si256((const __m256i*)a), bi));
+        __m256i m = _mm256_and_si256(_mm256_mul_epu32(_mm256_and_si256(s, mask), n0v), mask);
+        s = _mm256_add_epi64(s, _mm256_mul_epu32(m, _mm256_set1_epi64x((long long)n[0])));
+        __m256i carry = _mm256_srli_epi64(s, 26);   // digit i is now 0 mod 2^26
+        for (int j = 1; j < k; j++) {
+            __m256i aj = _mm256_loadu_si256((const __m256i*)(a + 4 * j));
+            __m256i* slot = (__m256i*)(scratch + 4 * (i + j));
+            __m256i v = _mm256_add_epi64(_mm256_loadu_si256(slot), carry);
+            v = _mm256_add_epi64(v, _mm256_mul_epu32(aj, bi));
+            v = _mm256_add_epi64(v, _mm256_mul_epu32(m, _mm256_set1_epi64x((long long)n[j])));
+            _mm256_storeu_si256(slot, v);
+            carry = zero;
+        }
+        if (k == 1) {
+            __m256i* slot = (__m256i*)(scratch + 4 * (i + 1));
+            _mm256_storeu_si256(slot, _mm256_add_epi64(_mm256_loadu_si256(slot), carry));
+        }
+    }
+    __m256i carry = zero;
+    for (int t = 0; t < k; t++) {
+        __m256i v = _mm256_add_epi64(_mm256_loadu_si256((const __m256i*)(scratch + 4 * (k + t))), carry);
+        _mm256_storeu_si256((__m256i*)(out + 4 * t), _mm256_and_si256(v, mask));
+        carry = _mm256_srli_epi64(v, 26);
+    }
+}
+
+// ---- lane-parallel Montgomery context (same modulus in every lane) ----
+
+struct SimdMontgomery {
+    typedef void (*Kernel)(u64*, const u64*, const u64*, const u64*, u64, int, u64*);
+
+    BigInt mod;
+    int lanes, radix, k;
+    u64 mask, n0;
+    vector<u64> n;          // modulus digits
+    vector<u64> one, r2;    // R mod n and R^2 mod n, interleaved (same value in every lane)
+    Kernel kernel;
+
+    SimdMontgomery(const BigInt& m, SimdLevel level) : mod(m) {
+        if (!mod.isOdd()) throw invalid_argument("SimdMontgomery needs an odd modulus");
+        if (level == SimdLevel::IFMA) lanes = 8, radix = 52, kernel = montMulIFMA;
+        else if (level == SimdLevel::AVX2) lanes = 4, radix = 26, kernel = montMulAVX2;
+        else throw invalid_argument("SimdMontgomery needs AVX2 or AVX-512 IFMA");
+        mask = (1ULL << radix) - 1;
+        k = (mod.bitLength() + 2 + radix - 1) / radix;   // R = 2^(radix * k) > 4n
+        n = digits(mod);
+        u64 inv = mod.low();
+        for (int i = 0; i < 5; i++) inv *= 2 - mod.low() * inv;
+        n0 = ((u64)0 - inv) & mask;
+        one = broadcast((BigInt(1) << (radix * k)) % mod);
+        r2 = broadcast((BigInt(1) << (2 * radix * k)) % mod);
+    }
+
+    // k digits of x (0 <= x < 2^(radix * k))
+    vector<u64> digits(const BigInt& x) const {
+        vector<u64> d(k, 0);
+        for (int j = 0; j < k; j++) {
+            int bit = j * radix, w = bit / 64, off = bit % 64;
+            u64 v = w < x.limbs() ? x.mag[w] >> off : 0;
+            if (off + radix > 64 && w + 1 < x.limbs()) v |= x.mag[w + 1] << (64 - off);
+            d[j] = v & mask;
+        }
+        return d;
+    }
+
+    vector<u64> broadcast(const BigInt& x) const {
+        vector<u64> d = digits(x), v(k * lanes);
+        for (int j = 0; j < k; j++)
+            for (int l = 0; l < lanes; l++) v[j * lanes + l] = d[j];
+        return v;
+    }
+
+    // Lanes 0..count-1 from xs[off..], reduced mod n; missing lanes are 0
+    vector<u64> load(const vector<BigInt>& xs, size_t off) const {
+        vector<u64> v(k * lanes, 0);
+        for (int l = 0; l < lanes && off + l < xs.size(); l++) {
+            BigInt x = xs[off + l] % mod;
+            if (x.neg) x += mod;
+            vector<u64> d = digits(x);
+            for (int j = 0; j < k; j++) v[j * lanes + l] = d[j];
+        }
+        return v;
+    }
+
+    BigInt lane(const vector<u64>& v, int l) const {
+        BigInt x;
+        for (int j = k - 1; j >= 0; j--) x = (x << radix) + BigInt((long long)v[j * lanes + l]);
+        return x;
+    }
+
+    u64* workspace() const {
+        static thread_local vector<u64> buf;
+        size_t need = (size_t)(2 * k + 1) * lanes;
+        if (buf.size() < need) buf.assign(need, 0);
+        return buf.data();
+    }
+
+    // Engine interface (see slidingWindowPow in modarith.h)
+    void mulInto(vector<u64>& out, const vector<u64>& a, const vector<u64>& b) const {
+        out.resize(k * lanes);
+        kernel(out.data(), a.data(), b.data(), n.data(), n0, k, workspace());
+    }
+    void sqrInto(vector<u64>& out, const vector<u64>& a) const { mulInto(out, a, a); }
+    void select(vector<u64>& out, const vector<vector<u64>>& table, u64 idx) const {
+        out.assign(k * lanes, 0);
+        for (size_t i = 0; i < table.size(); i++) {
+            u64 sel = (u64)0 - (u64)(i == idx);
+            for (size_t j = 0; j < out.size(); j++) out[j] |= table[i][j] & sel;
+        }
+    }
+
+    vector<u64> toMont(const vector<u64>& x) const {
+        vector<u64> r;
+        mulInto(r, x, r2);
+        return r;
+    }
+
+    // Leaves Montgomery form and writes lanes 0..count-1 to res[off..], fully reduced
+    void fromMont(const vector<u64>& x, vector<BigInt>& res, size_t off, size_t count) const {
+        vector<u64> unit(k * lanes, 0), r;
+        for (int l = 0; l < lanes; l++) unit[l] = 1;
+        mulInto(r, x, unit);
+        for (size_t l = 0; l < count; l++) {
+            BigInt v = lane(r, (int)l);
+            if (v >= mod) v -= mod;
+            res[off + l] = v;
+        }
+    }
+};
+
+// bases[i]^exp mod `mod` for every i, all sharing one exponent and one modulus.
+// Groups of lanes go through the SIMD kernels; even moduli or no SIMD fall back to power().
+inline vector<BigInt> batchPower(const vector<BigInt>& bases, const BigInt& exp, const BigInt& mod,
+                                 SimdLevel level = detectSimd()) {
+    vector<BigInt> res(bases.size());
+    if (level == SimdLevel::Scalar || !mod.isOdd() || mod == BigInt(1)) {
+        for (size_t i = 0; i < bases.size(); i++) res[i] = power(bases[i], exp, mod);
+        return res;
+    }
+    SimdMontgomery ctx(mod, level);
+    for (size_t off = 0; off < bases.size(); off += ctx.lanes) {
+        size_t count = min((size_t)ctx.lanes, bases.size() - off);
+        vector<u64> x = ctx.toMont(ctx.load(bases, off));
+        vector<u64> r = exp.isZero() ? ctx.one
+                                     : slidingWindowPow(ctx, x, exp.bitLength(), [&exp](int i) { return exp.bit(i); });
+        ctx.fromMont(r, res, off, count);
+    }
+    return res;
+}
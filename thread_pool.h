@@ -0,0 +1,224 @@
+/*
+    thread_pool.h — small fixed-size worker pool for the search / batch demos
+
+    Purpose:
+    - One place for the "spread this loop over the cores" plumbing, so the
+        programs that brute-force, factor or process batches share the same pool.
+
+    Contents:
+    - ThreadPool: fixed set of worker threads draining a FIFO task queue;
+        submit() returns a std::future for the task's result.
+    - parallelFor: runs fn(i) for i in [0, count) on a pool, handing out indices
+        dynamically (good when iterations have uneven cost), and waits for all.
+    - orderedPipeline: reader -> pool -> writer for streaming jobs; batches are
+        processed in parallel but written in input order, with a bounded number
+        in flight so memory stays flat however long the stream is.
+    - BoundedQueue: fixed-capacity lock-free multi-producer / multi-consumer
+        queue (Vyukov's ring of sequence-numbered cells) for handing precomputed
+        items from background threads to callers without taking a lock.
+
+    Notes:
+    - threads = 0 means one worker per hardware thread.
+    - Tasks must not block waiting on other tasks of the same pool.
+*/
+
+#pragma once
+
+#include <bits/stdc++.h>
+using namespace std;
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; i++) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned)workers.size(); }
+
+    template <class F>
+    auto submit(F fn) -> future<decltype(fn())> {
+        auto task = make_shared<packaged_task<decltype(fn())()>>(move(fn));
+        future<decltype(fn())> result = task->get_future();
+        {
+            lock_guard<mutex> lock(m);
+            tasks.push([task] { (*task)(); });
+        }
+        cv.notify_one();
+        return result;
+    }
+
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex m;
+    condition_variable cv;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+// Runs fn(i) for every i in [0, count) using all workers of the pool; returns when done.
+// Indices are claimed one at a time from a shared counter, so slow items do not stall a worker's share.
+template <class F>
+void parallelFor(ThreadPool& pool, long long count, F fn) {
+    atomic<long long> next(0);
+    vector<future<void>> done;
+    for (unsigned w = 0; w < pool.size(); w++) {
+        done.push_back(pool.submit([&] {
+            for (long long i = next++; i < count; i = next++) fn(i);
+        }));
+    }
+    for (auto& f : done) f.get();
+}
+
+// Streams batches through the pool: read(batch) fills the next batch on the calling thread
+// (false at end of input), work(batch) runs on a pool worker, and write(batch) runs on a
+// dedicated writer thread in the order the batches were read. The reader stalls once
+// `window` batches are waiting to be written. work must not throw.
+template <class Batch, class Read, class Work, class Write>
+void orderedPipeline(ThreadPool& pool, size_t window, Read read, Work work, Write write) {
+    mutex m;
+    condition_variable cv;
+    deque<future<shared_ptr<Batch>>> pending;   // submitted, not yet written, in read order
+    bool done = false;
+
+    thread writer([&] {
+        while (true) {
+            future<shared_ptr<Batch>> next;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&] { return done || !pending.empty(); });
+                if (pending.empty()) return;
+                next = move(pending.front());
+                pending.pop_front();
+            }
+            cv.notify_all();
+            write(*next.get());
+        }
+    });
+
+    while (true) {
+        auto batch = make_shared<Batch>();
+        if (!read(*batch)) break;
+        auto result = pool.submit([batch, &work] {
+            work(*batch);
+            return batch;
+        });
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [&] { return pending.size() < max<size_t>(window, 1); });
+        pending.push_back(move(result));
+        lock.unlock();
+        cv.notify_all();
+    }
+    {
+        lock_guard<mutex> lock(m);
+        done = true;
+    }
+    cv.notify_all();
+    writer.join();
+}
+
+// Lock-free bounded MPMC queue. Each cell carries a sequence number that says whose turn
+// it is: seq == pos means free for the producer claiming ticket pos, seq == pos + 1 means
+// filled for the consumer claiming ticket pos. Producers and consumers only CAS their own
+// ticket counter, so tryPush / tryPop never block and never take a lock.
+template <class T>
+class BoundedQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit BoundedQueue(size_t capacity) {
+        size_t cap = 1;
+        while (cap < max<size_t>(capacity, 2)) cap <<= 1;
+        mask = cap - 1;
+        cells.reset(new Cell[cap]);
+        for (size_t i = 0; i < cap; i++) cells[i].seq.store(i, memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // Number of items, exact when no push / pop is in flight
+    size_t size() const {
+        size_t t = tail.load(memory_order_acquire), h = head.load(memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    // false when the queue is full (value is left untouched)
+    bool tryPush(T& value) {
+        size_t pos = tail.load(memory_order_relaxed);
+        while (true) {
+            Cell& c = cells[pos & mask];
+            size_t seq = c.seq.load(memory_order_acquire);
+            long long diff = (long long)seq - (long long)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    c.value = move(value);
+                    c.seq.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // false when the queue is empty
+    bool tryPop(T& out) {
+        size_t pos = head.load(memory_order_relaxed);
+        while (true) {
+            Cell& c = cells[pos & mask];
+            size_t seq = c.seq.load(memory_order_acquire);
+            long long diff = (long long)seq - (long long)(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    out = move(c.value);
+                    c.seq.store(pos + mask + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        atomic<size_t> seq;
+        T value;
+    };
+    unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) atomic<size_t> head{0};   // next ticket to pop
+    alignas(64) atomic<size_t> tail{0};   // next ticket to push
+};